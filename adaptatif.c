@@ -0,0 +1,67 @@
+#include <stdlib.h>
+#include "adaptatif.h"
+
+/**
+   Réunit, dans la forêt réinitialisée \a foret, les composantes
+   adaptatives de \a plans (voir adaptatif.h), dans le voisinage choisi
+   (choisirConnexite).
+*/
+void unirAdaptatif( const PlansTSV* plans, Foret* foret, double k )
+{
+  uint32_t n = foret->taille;
+  uint32_t nb_aretes;
+  uint32_t* debuts = (uint32_t*) malloc( ( POIDS_MAX + 2 ) * sizeof( uint32_t ) );
+  uint32_t* aretes = trierAretesTSV( plans, connexiteChoisie(), &nb_aretes, debuts );
+  // Par racine: nombre de pixels, et seuil interne + k / taille des
+  // arêtes qu'elle accepte (gardé plutôt que recalculé à chaque arête).
+  uint32_t* taille = (uint32_t*) malloc( n * sizeof( uint32_t ) );
+  double* seuil = (double*) malloc( n * sizeof( double ) );
+  for ( uint32_t i = 0; i < n; ++i )
+  {
+    taille[ i ] = 1;
+    seuil[ i ] = k;
+  }
+
+  // Les arêtes de poids w sont aretes[ debuts[ w ] .. debuts[ w + 1 ] [.
+  for ( int w = 0; w <= POIDS_MAX; ++w )
+    for ( uint32_t e = debuts[ w ]; e < debuts[ w + 1 ]; ++e )
+    {
+      uint32_t i = aretes[ e ] / 4;
+      uint32_t u = foretTrouver( foret, i );
+      uint32_t v = foretTrouver( foret, extremiteArete( plans, i, aretes[ e ] % 4 ) );
+      if ( u == v || w > seuil[ u ] || w > seuil[ v ] ) continue;
+      INSTRUMENTER( compterUnion( 1 ); )
+      // union par rang, comme unionOpti; les arêtes venant par poids
+      // croissant, w est le plus grand poids interne de la réunion
+      uint32_t racine = u, fille = v;
+      if ( foret->rang[ u ] <= foret->rang[ v ] )
+      {
+        racine = v;
+        fille = u;
+        if ( foret->rang[ u ] == foret->rang[ v ] )
+          foret->rang[ v ] += 1;
+      }
+      foret->pere[ fille ] = racine;
+      taille[ racine ] += taille[ fille ];
+      seuil[ racine ] = w + k / taille[ racine ];
+    }
+  free( seuil );
+  free( taille );
+  free( aretes );
+  free( debuts );
+}
+
+/**
+   Composantes adaptatives de \a input (plans TSV \a plans déjà
+   calculés), coloriées dans \a output avec leur couleur moyenne, comme
+   calculerComposantesConnexesFlouesPlans. Rend FALSE si le suivi des
+   tampons a interrompu le calcul.
+*/
+bool calculerComposantesAdaptatives( const Image* input, Image* output,
+                                     const PlansTSV* plans, double k, Tampons* tampons )
+{
+  if ( ! annoncerPhase( tampons, AVANCEMENT_UNIONS ) ) return FALSE;
+  Foret* foret = preparerTampons( tampons, (uint32_t) output->width * output->height );
+  unirAdaptatif( plans, foret, k );
+  return colorierPhases( input, output, tampons );
+}
@@ -0,0 +1,36 @@
+#ifndef ADAPTATIF_H
+#define ADAPTATIF_H
+
+/**
+   Composantes floues adaptatives (Felzenszwalb et Huttenlocher, 2004).
+
+   Avec un seuil floue unique, une zone texturée (kowloon-1000.jpg) se
+   fond avec ses voisines, alors qu'un dégradé lisse (le fond de
+   papillon-express.jpg) se découpe en bandes. Ici le seuil dépend des
+   composantes: chaque racine de la forêt porte sa taille et le plus
+   grand poids interne de sa composante, c'est-à-dire le poids de la
+   dernière arête qui l'a réunie. Les arêtes sont triées une fois par
+   poids croissant (trierAretesTSV), et l'arête ( a, b ) de poids w
+   réunit les composantes A et B si
+
+     w <= min( interne( A ) + k / | A |, interne( B ) + k / | B | )
+
+   Une petite composante accepte donc des arêtes plus lourdes que sa
+   propre variation; une grande ne s'étend que vers des voisins aussi
+   homogènes qu'elle. \a k (en unités de poids, voir plans-tsv.h) règle
+   la taille des composantes: plus il est grand, moins il y en a.
+
+   Tri par dénombrement et union par rang avec compression, comme
+   unionOpti: le temps reste quasi linéaire en le nombre de pixels.
+*/
+
+#include <stdint.h>
+#include "segmentation.h"
+#include "plans-tsv.h"
+#include "tampons.h"
+
+void unirAdaptatif( const PlansTSV* plans, Foret* foret, double k );
+bool calculerComposantesAdaptatives( const Image* input, Image* output,
+                                     const PlansTSV* plans, double k, Tampons* tampons );
+
+#endif
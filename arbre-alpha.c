@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <string.h>
+#include "arbre-alpha.h"
+
+/**
+   Construit l'arbre alpha des poids de \a plans, dans le voisinage
+   choisi (choisirConnexite).
+*/
+ArbreAlpha* construireArbreAlpha( const PlansTSV* plans )
+{
+  int width = plans->width;
+  int height = plans->height;
+  uint32_t n = (uint32_t) width * height;
+  Connexite connexite = connexiteChoisie();
+  uint32_t nb_aretes;
+  uint32_t* aretes = trierAretesTSV( plans, connexite, &nb_aretes, NULL );
+
+  ArbreAlpha* arbre = (ArbreAlpha*) malloc( sizeof( ArbreAlpha ) );
+  arbre->width = width;
+  arbre->height = height;
+  arbre->connexite = connexite;
+  arbre->nb_feuilles = n;
+  arbre->parent = (uint32_t*) malloc( ( 2 * n ) * sizeof( uint32_t ) );
+  arbre->niveau = (uint16_t*) malloc( ( 2 * n ) * sizeof( uint16_t ) );
+  for ( uint32_t k = 0; k < n; ++k )
+  {
+    arbre->parent[ k ] = k;
+    arbre->niveau[ k ] = 0;
+  }
+
+  // Kruskal: noeud[ r ] est le noeud de l'arbre qui représente l'ensemble de racine r.
+  Foret* foret = creerForet( n );
+  uint32_t* noeud = (uint32_t*) malloc( n * sizeof( uint32_t ) );
+  for ( uint32_t i = 0; i < n; ++i )
+    noeud[ i ] = i;
+  uint32_t suivant = n;
+  for ( uint32_t e = 0; e < nb_aretes && suivant < 2 * n - 1; ++e )
+  {
+    uint32_t i = aretes[ e ] / 4;
+    int d = aretes[ e ] % 4;
+    uint32_t j = extremiteArete( plans, i, d );
+    uint32_t u = foretTrouver( foret, i );
+    uint32_t v = foretTrouver( foret, j );
+    if ( u == v ) continue;
+    uint32_t k = suivant++;
+    arbre->parent[ k ] = k;
+    arbre->niveau[ k ] = poidsArete( plans, i, d );
+    arbre->parent[ noeud[ u ] ] = k;
+    arbre->parent[ noeud[ v ] ] = k;
+    foretUnion( foret, u, v );
+    noeud[ foretTrouver( foret, u ) ] = k;
+  }
+  arbre->nb_noeuds = suivant;
+  arbre->etiquettes = (uint32_t*) malloc( suivant * sizeof( uint32_t ) );
+  arbre->sommes = (SommeCouleur*) malloc( n * sizeof( SommeCouleur ) );
+  arbre->couleurs = (Pixel*) malloc( n * sizeof( Pixel ) );
+  free( noeud );
+  libererForet( foret );
+  free( aretes );
+  return arbre;
+}
+
+void libererArbreAlpha( ArbreAlpha* arbre )
+{
+  free( arbre->couleurs );
+  free( arbre->sommes );
+  free( arbre->etiquettes );
+  free( arbre->niveau );
+  free( arbre->parent );
+  free( arbre );
+}
+
+/**
+   Étiquette chaque noeud par le plus haut de ses ancêtres de niveau
+   <= floue. Les parents étant créés après leurs enfants, un seul
+   parcours par indices décroissants suffit. Les composantes reçoivent
+   des étiquettes compactes 0 .. nb-1 (les noeuds au-dessus de la coupe
+   n'en ont pas); celles des pixels sont les nb_feuilles premières
+   valeurs de arbre->etiquettes. Rend nb.
+*/
+uint32_t etiqueterArbreAlpha( ArbreAlpha* arbre, double floue )
+{
+  uint32_t* etiquettes = arbre->etiquettes;
+  uint32_t nb = 0;
+  for ( uint32_t k = arbre->nb_noeuds; k-- > 0; )
+  {
+    uint32_t p = arbre->parent[ k ];
+    if ( p != k && arbre->niveau[ p ] <= floue )
+      etiquettes[ k ] = etiquettes[ p ];
+    else if ( k < arbre->nb_feuilles || arbre->niveau[ k ] <= floue )
+      etiquettes[ k ] = nb++;
+  }
+  return nb;
+}
+
+/**
+   Même résultat que calculerComposantesConnexesFloues( input, output, floue ),
+   mais sans aucune union: on lit les composantes dans l'arbre.
+*/
+void composantesArbreAlpha( ArbreAlpha* arbre, const Image* input, Image* output, double floue )
+{
+  uint32_t nb = etiqueterArbreAlpha( arbre, floue );
+  const uint32_t* etiquettes = arbre->etiquettes;
+  SommeCouleur* sommes = arbre->sommes;
+  memset( sommes, 0, nb * sizeof( SommeCouleur ) );
+  uint32_t i = 0;
+  for ( int y = 0; y < input->height; ++y )
+  {
+    Pixel* ligne = pixelImage( input, 0, y );
+    for ( int x = 0; x < input->width; ++x, ++i )
+    {
+      SommeCouleur* s = &sommes[ etiquettes[ i ] ];
+      const Pixel* pixel = PIXEL_LIGNE( ligne, x, input->canaux );
+      s->rouge += pixel->rouge;
+      s->vert  += pixel->vert;
+      s->bleu  += pixel->bleu;
+      s->nb += 1;
+    }
+  }
+  for ( uint32_t e = 0; e < nb; ++e )
+  {
+    arbre->couleurs[ e ].rouge = sommes[ e ].rouge / sommes[ e ].nb;
+    arbre->couleurs[ e ].vert  = sommes[ e ].vert  / sommes[ e ].nb;
+    arbre->couleurs[ e ].bleu  = sommes[ e ].bleu  / sommes[ e ].nb;
+  }
+  i = 0;
+  for ( int y = 0; y < output->height; ++y )
+  {
+    Pixel* ligne = pixelImage( output, 0, y );
+    for ( int x = 0; x < output->width; ++x, ++i )
+      *PIXEL_LIGNE( ligne, x, output->canaux ) = arbre->couleurs[ etiquettes[ i ] ];
+  }
+}
@@ -0,0 +1,43 @@
+#ifndef ARBRE_ALPHA_H
+#define ARBRE_ALPHA_H
+
+/**
+   Arbre alpha (hiérarchie de fusions) pour les composantes floues.
+
+   On trie une fois toutes les arêtes entre voisins par poids (tri par
+   dénombrement, les poids sont bornés), puis on fait Kruskal avec la
+   forêt compacte. Chaque union crée un noeud de l'arbre, de niveau le
+   poids de l'arête: les feuilles sont les pixels, le parent d'un noeud
+   est la fusion suivante de son ensemble. Les niveaux croissent vers
+   la racine.
+
+   Les composantes pour un seuil floue sont alors les sous-arbres des
+   noeuds de niveau <= floue dont le parent est de niveau > floue: on
+   les lit en temps linéaire, sans refaire d'union, pour n'importe
+   quelle valeur du curseur.
+*/
+
+#include <stdint.h>
+#include "segmentation.h"
+#include "plans-tsv.h"
+#include "tampons.h"
+
+typedef struct {
+  int width;
+  int height;
+  Connexite connexite;  // voisinage choisi à la construction
+  uint32_t nb_feuilles; // width * height, les feuilles sont les noeuds 0 .. nb_feuilles - 1
+  uint32_t nb_noeuds;   // feuilles et fusions
+  uint32_t* parent;     // parent[ k ] > k, ou k pour une racine
+  uint16_t* niveau;     // 0 pour une feuille, poids de l'arête de fusion sinon
+  uint32_t* etiquettes; // étiquettes compactes des noeuds (etiqueterArbreAlpha)
+  SommeCouleur* sommes; // par composante, au plus nb_feuilles
+  Pixel* couleurs;      // par composante
+} ArbreAlpha;
+
+ArbreAlpha* construireArbreAlpha( const PlansTSV* plans );
+void libererArbreAlpha( ArbreAlpha* arbre );
+uint32_t etiqueterArbreAlpha( ArbreAlpha* arbre, double floue );
+void composantesArbreAlpha( ArbreAlpha* arbre, const Image* input, Image* output, double floue );
+
+#endif
@@ -0,0 +1,430 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "segmentation.h"
+#include "image-pixbuf.h"
+#include "parallele.h"
+#include "plages.h"
+#include "tampons.h"
+
+/**
+   Banc d'essai des variantes de Union-Find (question 3.4).
+
+   Les variantes "opti", "deux-passes", "demi-chemin" et "scission"
+   utilisent toutes unionOpti et ne diffèrent que par la recherche du
+   représentant (récursive, ou itérative en deux passes, par demi-chemin
+   ou par scission).
+
+   Avec --threads 1,2,4,8,16, on mesure aussi les composantes
+   multi-threads pour chacun de ces nombres de threads, par bandes
+   (parallele-n) et sur une forêt partagée sans verrou (concurrente-n),
+   et on donne l'accélération par rapport à parallele-1.
+
+   Pour chaque image, on seuille l'entrée puis on chronomètre les
+   composantes connexes phase par phase: création des ensembles (1),
+   unions (2-3), statistiques (4-6) et recoloriage (7-8). Chaque mesure
+   est précédée de tours de chauffe et répétée; on donne la médiane et
+   le 95e centile.
+
+   prompt$ ./bench --repeat 20 --csv bench.csv --json bench.json
+   prompt$ ./bench --variants opti,demi-chemin kowloon-1000.jpg
+
+   Compilé avec INSTRUMENTATION=-DINSTRUMENTATION, --instrumentation
+   écrit les compteurs de l'union-find (instrumentation.h), cumulés sur
+   tous les tours: mesurez alors une seule variante sur une seule image.
+*/
+
+/// Structure de données utilisée par une variante.
+typedef enum {
+  MOTEUR_OBJET, // tableau d'Objet (pixel, rang, pere)
+  MOTEUR_FORET, // Foret compacte (pere[] et rang[])
+  MOTEUR_PARALLELE, // Foret compacte, par bandes sur plusieurs threads
+  MOTEUR_CONCURRENT, // Foret compacte partagée, unions sans verrou sur plusieurs threads
+  MOTEUR_PLAGES,    // Foret compacte sur les plages de même gris
+  MOTEUR_TAMPONS    // Foret compacte dans des tampons réutilisés, coloriage fusionné
+} Moteur;
+
+/// Une variante d'union-find à mesurer.
+typedef struct {
+  const char* nom;
+  Moteur moteur;
+  FonctionUnion unir;     // pour MOTEUR_OBJET
+  MethodeTrouver trouver; // utilisée aussi par les étapes 6 et 8
+  int nb_threads;         // pour MOTEUR_PARALLELE et MOTEUR_CONCURRENT
+} Variante;
+
+static const Variante VARIANTES[] = {
+  { "basique",     MOTEUR_OBJET, unionPasOpti,     TROUVER_DEUX_PASSES },
+  { "compression", MOTEUR_OBJET, unionCompression, TROUVER_DEUX_PASSES },
+  { "rang",        MOTEUR_OBJET, unionRang,        TROUVER_DEUX_PASSES },
+  { "opti",        MOTEUR_OBJET, unionOpti,        TROUVER_RECURSIF },
+  { "deux-passes", MOTEUR_OBJET, unionOpti,        TROUVER_DEUX_PASSES },
+  { "demi-chemin", MOTEUR_OBJET, unionOpti,        TROUVER_DEMI_CHEMIN },
+  { "scission",    MOTEUR_OBJET, unionOpti,        TROUVER_SCISSION },
+  { "compact",     MOTEUR_FORET, NULL,             TROUVER_DEMI_CHEMIN },
+  { "tampons",     MOTEUR_TAMPONS, NULL,           TROUVER_DEMI_CHEMIN },
+  { "plages",      MOTEUR_PLAGES, NULL,            TROUVER_DEMI_CHEMIN },
+};
+#define NB_VARIANTES ( (int) ( sizeof( VARIANTES ) / sizeof( VARIANTES[ 0 ] ) ) )
+#define MAX_PARALLELES 16
+
+static const char* IMAGES_FOURNIES[] = {
+  "pac-v1.png", "pac-v2.png", "cameraman.pgm", "lena.pgm", "lena.png",
+  "kowloon-1000.jpg", "papillon-express.jpg",
+};
+#define NB_IMAGES_FOURNIES ( (int) ( sizeof( IMAGES_FOURNIES ) / sizeof( IMAGES_FOURNIES[ 0 ] ) ) )
+
+/// Les phases chronométrées.
+enum { PHASE_CREATION, PHASE_UNION, PHASE_STATS, PHASE_REPEINT, PHASE_TOTAL, NB_PHASES };
+static const char* NOMS_PHASES[ NB_PHASES ] = { "creation", "union", "stats", "repeint", "total" };
+
+/// Résultat d'une mesure (médiane et 95e centile, en ms).
+typedef struct {
+  const char* image;
+  int pixels;
+  const char* variante;
+  double mediane[ NB_PHASES ];
+  double p95[ NB_PHASES ];
+  double acceleration; // temps total de référence / temps total (0 si sans objet)
+} Mesure;
+
+//-----------------------------------------------------------------------------
+// Déclaration des fonctions
+//-----------------------------------------------------------------------------
+double maintenant( void );
+bool listeContient( const char* liste, const char* nom );
+int compareDoubles( const void* a, const void* b );
+double centile( double* valeurs, int n, double p );
+void unTour( const Variante* variante, const Image* input, Image* output, double* t );
+void mesurer( const Image* input, const Image* seuillee, Image* output,
+              const Variante* variante, int chauffe, int repetitions, Mesure* m );
+void ecrireCSV( FILE* f, Mesure* mesures, int nb, int repetitions );
+void ecrireJSON( FILE* f, Mesure* mesures, int nb, int repetitions );
+
+//-----------------------------------------------------------------------------
+// Programme principal
+//-----------------------------------------------------------------------------
+int main( int   argc,
+          char* argv[] )
+{
+  int chauffe = 2;
+  int repetitions = 10;
+  int seuil = 128;
+  const char* csv  = NULL;
+  const char* json = NULL;
+  const char* instrumentation = NULL;
+  const char* variantes = "basique,compression,rang,opti,deux-passes,demi-chemin,scission,compact,tampons,plages";
+  const char* threads = NULL;
+  const char** images = NULL;
+  int nb_images = 0;
+
+  images = (const char**) malloc( ( argc + NB_IMAGES_FOURNIES ) * sizeof( const char* ) );
+  for ( int i = 1; i < argc; ++i )
+  {
+    if ( strcmp( argv[ i ], "--warmup" ) == 0 && i + 1 < argc )        chauffe = atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--repeat" ) == 0 && i + 1 < argc )   repetitions = atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--threshold" ) == 0 && i + 1 < argc ) seuil = atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--csv" ) == 0 && i + 1 < argc )      csv = argv[ ++i ];
+    else if ( strcmp( argv[ i ], "--json" ) == 0 && i + 1 < argc )     json = argv[ ++i ];
+    else if ( strcmp( argv[ i ], "--instrumentation" ) == 0 && i + 1 < argc ) instrumentation = argv[ ++i ];
+    else if ( strcmp( argv[ i ], "--variants" ) == 0 && i + 1 < argc ) variantes = argv[ ++i ];
+    else if ( strcmp( argv[ i ], "--threads" ) == 0 && i + 1 < argc )  threads = argv[ ++i ];
+    else if ( argv[ i ][ 0 ] == '-' )
+    {
+      fprintf( stderr, "usage: %s [--warmup n] [--repeat n] [--threshold s] [--variants v1,v2]"
+               " [--threads n1,n2] [--csv f] [--json f] [--instrumentation f] [images...]\n", argv[ 0 ] );
+      return 1;
+    }
+    else images[ nb_images++ ] = argv[ i ];
+  }
+  if ( repetitions < 1 ) repetitions = 1;
+  if ( nb_images == 0 )
+    for ( int i = 0; i < NB_IMAGES_FOURNIES; ++i )
+      images[ nb_images++ ] = IMAGES_FOURNIES[ i ];
+
+  // Variantes à mesurer: celles de la liste, puis une par nombre de threads.
+  static char noms_paralleles[ 2 * MAX_PARALLELES ][ 32 ];
+  Variante choisies[ NB_VARIANTES + 2 * MAX_PARALLELES ];
+  int nb_choisies = 0;
+  int nb_paralleles = 0;
+  for ( int v = 0; v < NB_VARIANTES; ++v )
+    if ( listeContient( variantes, VARIANTES[ v ].nom ) )
+      choisies[ nb_choisies++ ] = VARIANTES[ v ];
+  for ( const char* p = threads; p != NULL && nb_paralleles < 2 * MAX_PARALLELES;
+        p = strchr( p, ',' ) ? strchr( p, ',' ) + 1 : NULL )
+    for ( int concurrent = 0; concurrent < 2; ++concurrent )
+    {
+      Variante* v = &choisies[ nb_choisies++ ];
+      v->moteur     = concurrent ? MOTEUR_CONCURRENT : MOTEUR_PARALLELE;
+      v->unir       = NULL;
+      v->trouver    = TROUVER_DEMI_CHEMIN;
+      v->nb_threads = atoi( p ) < 1 ? 1 : atoi( p );
+      snprintf( noms_paralleles[ nb_paralleles ], 32, concurrent ? "concurrente-%d" : "parallele-%d",
+                v->nb_threads );
+      v->nom = noms_paralleles[ nb_paralleles++ ];
+    }
+
+  Mesure* mesures = (Mesure*) malloc( nb_images * nb_choisies * sizeof( Mesure ) );
+  int nb_mesures = 0;
+
+  printf( "%-22s %-12s %10s %10s %10s %10s %10s   (mediane / p95 en ms)\n",
+          "image", "variante", "creation", "union", "stats", "repeint", "total" );
+  for ( int i = 0; i < nb_images; ++i )
+  {
+    GError* error = NULL;
+    GdkPixbuf* pixbuf = gdk_pixbuf_new_from_file( images[ i ], &error );
+    if ( pixbuf == NULL )
+    {
+      fprintf( stderr, "%s: %s\n", images[ i ], error->message );
+      g_error_free( error );
+      continue;
+    }
+    if ( ! pixbufCompatible( pixbuf ) )
+    {
+      fprintf( stderr, "%s: format non supporte\n", images[ i ] );
+      g_object_unref( pixbuf );
+      continue;
+    }
+    GdkPixbuf* pixbuf_seuil  = gdk_pixbuf_copy( pixbuf );
+    GdkPixbuf* pixbuf_output = gdk_pixbuf_copy( pixbuf );
+    Image input    = imageDepuisPixbuf( pixbuf );
+    Image seuillee = imageDepuisPixbuf( pixbuf_seuil );
+    Image output   = imageDepuisPixbuf( pixbuf_output );
+    seuiller( &input, &seuillee, seuil );
+
+    Mesure* reference_parallele = NULL;
+    for ( int v = 0; v < nb_choisies; ++v )
+    {
+      Mesure* m = &mesures[ nb_mesures++ ];
+      m->image    = images[ i ];
+      m->pixels   = input.width * input.height;
+      m->variante = choisies[ v ].nom;
+      choisirMethodeTrouver( choisies[ v ].trouver );
+      mesurer( &input, &seuillee, &output, &choisies[ v ], chauffe, repetitions, m );
+      m->acceleration = 0.0;
+      if ( choisies[ v ].moteur == MOTEUR_PARALLELE || choisies[ v ].moteur == MOTEUR_CONCURRENT )
+      {
+        if ( reference_parallele == NULL ) reference_parallele = m;
+        m->acceleration = reference_parallele->mediane[ PHASE_TOTAL ] / m->mediane[ PHASE_TOTAL ];
+      }
+      printf( "%-22s %-12s", m->image, m->variante );
+      for ( int p = 0; p < NB_PHASES; ++p )
+        printf( " %10.3f", m->mediane[ p ] );
+      if ( m->acceleration > 0.0 )
+        printf( "   x%.2f", m->acceleration );
+      printf( "\n%-22s %-12s", "", "  p95" );
+      for ( int p = 0; p < NB_PHASES; ++p )
+        printf( " %10.3f", m->p95[ p ] );
+      printf( "\n" );
+      fflush( stdout );
+    }
+    g_object_unref( pixbuf_output );
+    g_object_unref( pixbuf_seuil );
+    g_object_unref( pixbuf );
+  }
+
+  if ( csv != NULL )
+  {
+    FILE* f = fopen( csv, "w" );
+    if ( f != NULL ) { ecrireCSV( f, mesures, nb_mesures, repetitions ); fclose( f ); }
+    else perror( csv );
+  }
+  if ( json != NULL )
+  {
+    FILE* f = fopen( json, "w" );
+    if ( f != NULL ) { ecrireJSON( f, mesures, nb_mesures, repetitions ); fclose( f ); }
+    else perror( json );
+  }
+  if ( instrumentation != NULL )
+  {
+    FILE* f = fopen( instrumentation, "w" );
+    if ( f != NULL ) { ecrireInstrumentationJSON( f ); fclose( f ); }
+    else perror( instrumentation );
+  }
+  free( mesures );
+  free( images );
+  return 0;
+}
+
+/**
+   Temps courant en ms (horloge monotone).
+*/
+double maintenant( void )
+{
+  struct timespec t;
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+/**
+   Vrai si \a nom est un des éléments de la liste \a liste séparée par des virgules.
+*/
+bool listeContient( const char* liste, const char* nom )
+{
+  size_t n = strlen( nom );
+  for ( const char* p = liste; p != NULL; p = strchr( p, ',' ) ? strchr( p, ',' ) + 1 : NULL )
+    if ( strncmp( p, nom, n ) == 0 && ( p[ n ] == ',' || p[ n ] == '\0' ) )
+      return TRUE;
+  return FALSE;
+}
+
+int compareDoubles( const void* a, const void* b )
+{
+  double x = *(const double*) a;
+  double y = *(const double*) b;
+  return ( x > y ) - ( x < y );
+}
+
+/**
+   Centile \a p (entre 0 et 1) des \a n valeurs (triées sur place).
+*/
+double centile( double* valeurs, int n, double p )
+{
+  qsort( valeurs, n, sizeof( double ), compareDoubles );
+  int k = (int) ( p * ( n - 1 ) + 0.5 );
+  return valeurs[ k ];
+}
+
+/**
+   Un calcul des composantes connexes de \a output; \a t reçoit les
+   instants de début de chaque phase et de fin (NB_PHASES valeurs).
+*/
+void unTour( const Variante* variante, const Image* input, Image* output, double* t )
+{
+  // Les variantes "tampons" et parallèles gardent leurs tampons d'un tour à l'autre.
+  static Tampons* tampons = NULL;
+  if ( tampons == NULL )
+    tampons = creerTampons();
+
+  if ( variante->moteur == MOTEUR_OBJET )
+  {
+    t[ 0 ] = maintenant();
+    Objet* objects = creerEnsembles( output );
+    t[ 1 ] = maintenant();
+    unirNiveauxDeGris( output, objects, variante->unir );
+    t[ 2 ] = maintenant();
+    StatCouleur* stats = calculerStats( input, output, objects );
+    t[ 3 ] = maintenant();
+    repeindreComposantes( output, objects, stats );
+    t[ 4 ] = maintenant();
+    free( stats );
+    free( objects );
+  }
+  else if ( variante->moteur == MOTEUR_PLAGES )
+  {
+    t[ 0 ] = maintenant();
+    Plages* plages = encoderPlages( output );
+    t[ 1 ] = maintenant();
+    unirPlages( plages );
+    t[ 2 ] = maintenant();
+    StatCouleur* stats = calculerStatsPlages( input, plages );
+    t[ 3 ] = maintenant();
+    repeindrePlages( output, plages, stats );
+    t[ 4 ] = maintenant();
+    free( stats );
+    libererPlages( plages );
+  }
+  else if ( variante->moteur == MOTEUR_PARALLELE || variante->moteur == MOTEUR_CONCURRENT )
+  {
+    int n = variante->nb_threads;
+    t[ 0 ] = maintenant();
+    Foret* foret = preparerTampons( tampons, (uint32_t) output->width * output->height );
+    t[ 1 ] = maintenant();
+    if ( variante->moteur == MOTEUR_CONCURRENT )
+      unirNiveauxDeGrisConcurrents( output, foret, n );
+    else
+      unirNiveauxDeGrisParallele( output, foret, n );
+    t[ 2 ] = maintenant();
+    uint32_t nb = sommerComposantesParallele( input, tampons, n );
+    t[ 3 ] = maintenant();
+    peindreComposantesParallele( output, tampons, nb, n );
+    t[ 4 ] = maintenant();
+  }
+  else if ( variante->moteur == MOTEUR_TAMPONS )
+  {
+    t[ 0 ] = maintenant();
+    Foret* foret = preparerTampons( tampons, (uint32_t) output->width * output->height );
+    t[ 1 ] = maintenant();
+    unirNiveauxDeGrisForet( output, foret );
+    t[ 2 ] = maintenant();
+    uint32_t nb = sommerComposantes( input, tampons );
+    t[ 3 ] = maintenant();
+    moyennerComposantes( tampons, nb );
+    peindreComposantes( output, tampons, 0, output->height );
+    t[ 4 ] = maintenant();
+  }
+  else
+  {
+    t[ 0 ] = maintenant();
+    Foret* foret = creerForet( (uint32_t) output->width * output->height );
+    t[ 1 ] = maintenant();
+    unirNiveauxDeGrisForet( output, foret );
+    t[ 2 ] = maintenant();
+    StatCouleur* stats = calculerStatsForet( input, foret );
+    t[ 3 ] = maintenant();
+    repeindreForet( output, foret, stats );
+    t[ 4 ] = maintenant();
+    free( stats );
+    libererForet( foret );
+  }
+}
+
+/**
+   Chronomètre les composantes connexes de \a seuillee avec la variante
+   \a variante, phase par phase.
+*/
+void mesurer( const Image* input, const Image* seuillee, Image* output,
+              const Variante* variante, int chauffe, int repetitions, Mesure* m )
+{
+  double* temps[ NB_PHASES ];
+  for ( int p = 0; p < NB_PHASES; ++p )
+    temps[ p ] = (double*) malloc( repetitions * sizeof( double ) );
+
+  for ( int r = -chauffe; r < repetitions; ++r )
+  {
+    double t[ NB_PHASES ];
+    for ( int y = 0; y < output->height; ++y )
+      memcpy( output->data + y * output->rowstride, seuillee->data + y * seuillee->rowstride,
+              (size_t) output->width * output->canaux );
+    unTour( variante, input, output, t );
+    if ( r < 0 ) continue; // tour de chauffe
+    for ( int p = 0; p < PHASE_TOTAL; ++p )
+      temps[ p ][ r ] = t[ p + 1 ] - t[ p ];
+    temps[ PHASE_TOTAL ][ r ] = t[ PHASE_TOTAL ] - t[ 0 ];
+  }
+
+  for ( int p = 0; p < NB_PHASES; ++p )
+  {
+    m->mediane[ p ] = centile( temps[ p ], repetitions, 0.5 );
+    m->p95[ p ]     = centile( temps[ p ], repetitions, 0.95 );
+    free( temps[ p ] );
+  }
+}
+
+void ecrireCSV( FILE* f, Mesure* mesures, int nb, int repetitions )
+{
+  fprintf( f, "image,pixels,variante,phase,repetitions,mediane_ms,p95_ms,acceleration\n" );
+  for ( int i = 0; i < nb; ++i )
+    for ( int p = 0; p < NB_PHASES; ++p )
+      fprintf( f, "%s,%d,%s,%s,%d,%.4f,%.4f,%.3f\n", mesures[ i ].image, mesures[ i ].pixels,
+               mesures[ i ].variante, NOMS_PHASES[ p ], repetitions,
+               mesures[ i ].mediane[ p ], mesures[ i ].p95[ p ], mesures[ i ].acceleration );
+}
+
+void ecrireJSON( FILE* f, Mesure* mesures, int nb, int repetitions )
+{
+  fprintf( f, "{\n  \"repetitions\": %d,\n  \"mesures\": [\n", repetitions );
+  for ( int i = 0; i < nb; ++i )
+  {
+    fprintf( f, "    { \"image\": \"%s\", \"pixels\": %d, \"variante\": \"%s\"",
+             mesures[ i ].image, mesures[ i ].pixels, mesures[ i ].variante );
+    for ( int p = 0; p < NB_PHASES; ++p )
+      fprintf( f, ", \"%s\": { \"mediane_ms\": %.4f, \"p95_ms\": %.4f }", NOMS_PHASES[ p ],
+               mesures[ i ].mediane[ p ], mesures[ i ].p95[ p ] );
+    if ( mesures[ i ].acceleration > 0.0 )
+      fprintf( f, ", \"acceleration\": %.3f", mesures[ i ].acceleration );
+    fprintf( f, " }%s\n", i + 1 < nb ? "," : "" );
+  }
+  fprintf( f, "  ]\n}\n" );
+}
@@ -0,0 +1,583 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "adaptatif.h"
+
+/// Un résultat en mémoire, dans la liste du plus récent au plus ancien.
+struct EntreeCache {
+  CleCache cle;
+  int width;
+  int height;
+  uint32_t nb;            // composantes
+  int octets;             // par étiquette: 1, 2 ou 4
+  unsigned char* etiquettes;
+  SommeCouleur* sommes;
+  size_t taille;          // octets occupés
+  bool sur_disque;        // déjà écrit dans le dossier
+  int references;         // la liste (ou la file des sorties) et chaque lecture en cours
+  EntreeCache* precedente;
+  EntreeCache* suivante;
+};
+
+/// En-tête d'un fichier du dossier, suivi des étiquettes puis des sommes.
+typedef struct {
+  char magie[ 8 ];
+  CleCache cle;
+  int32_t width;
+  int32_t height;
+  uint32_t nb;
+  uint32_t octets;
+} EnteteCache;
+
+static const char MAGIE_CACHE[ 8 ] = "UFCACHE1";
+
+//-----------------------------------------------------------------------------
+// Empreintes
+//-----------------------------------------------------------------------------
+/**
+   Empreinte en quatre voies indépendantes de 64 bits: les mots de 8
+   octets vont à tour de rôle dans chaque voie, pour que les
+   multiplications s'enchaînent en parallèle.
+*/
+typedef struct {
+  uint64_t voies[ 4 ];
+} Empreinte;
+
+#define PREMIER_EMPREINTE 0x9e3779b97f4a7c15ULL
+
+static inline uint64_t melangerMot( uint64_t h, uint64_t mot )
+{
+  h = ( h ^ mot ) * PREMIER_EMPREINTE;
+  return h ^ ( h >> 32 );
+}
+
+/// Finalisation de MurmurHash3: chaque bit d'entrée change la moitié des bits.
+static inline uint64_t finaliser( uint64_t h )
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  return h ^ ( h >> 33 );
+}
+
+static void ajouterOctets( Empreinte* e, const unsigned char* p, size_t n )
+{
+  size_t k = 0;
+  for ( ; k + 32 <= n; k += 32 )
+    for ( int v = 0; v < 4; ++v )
+    {
+      uint64_t mot;
+      memcpy( &mot, p + k + 8 * v, 8 );
+      e->voies[ v ] = melangerMot( e->voies[ v ], mot );
+    }
+  uint64_t reste[ 4 ] = { 0, 0, 0, 0 };
+  memcpy( reste, p + k, n - k );
+  for ( int v = 0; v < 4; ++v )
+    e->voies[ v ] = melangerMot( e->voies[ v ], reste[ v ] ^ ( n - k ) );
+}
+
+/// Ajoute les pixels de \a img, ligne par ligne (sans le bourrage des lignes).
+static void ajouterPixels( Empreinte* e, const Image* img )
+{
+  for ( int y = 0; y < img->height; ++y )
+    ajouterOctets( e, img->data + (size_t) y * img->rowstride, (size_t) img->width * img->canaux );
+}
+
+/**
+   Clé du résultat de l'opération \a type, de paramètre \a parametre
+   (floue, k, ignoré pour les composantes de même gris), avec la
+   connexité choisie. Les composantes de même gris dépendent aussi de
+   \a output, l'image seuillée; pour les autres, \a output peut être
+   NULL.
+*/
+CleCache cleCache( TypeResultat type, double parametre, const Image* input, const Image* output )
+{
+  Empreinte e = { { 1, 2, 3, 4 } };
+  uint64_t entete[ 4 ];
+  memcpy( &entete[ 0 ], &parametre, 8 );
+  entete[ 1 ] = (uint64_t) type << 32 | (uint64_t) connexiteChoisie() << 8 | (uint64_t) input->canaux;
+  entete[ 2 ] = (uint64_t) input->width << 32 | (uint64_t) input->height;
+  entete[ 3 ] = type == RESULTAT_COMPOSANTES;
+  ajouterOctets( &e, (const unsigned char*) entete, sizeof( entete ) );
+  ajouterPixels( &e, input );
+  if ( type == RESULTAT_COMPOSANTES )
+    ajouterPixels( &e, output );
+  CleCache cle;
+  cle.h[ 0 ] = finaliser( e.voies[ 0 ] ^ finaliser( e.voies[ 1 ] ) );
+  cle.h[ 1 ] = finaliser( e.voies[ 2 ] ^ finaliser( e.voies[ 3 ] ^ cle.h[ 0 ] ) );
+  return cle;
+}
+
+//-----------------------------------------------------------------------------
+// Résultats
+//-----------------------------------------------------------------------------
+static inline uint32_t lireEtiquette( const unsigned char* etiquettes, int octets, uint32_t i )
+{
+  if ( octets == 1 ) return etiquettes[ i ];
+  if ( octets == 2 ) return ( (const uint16_t*) etiquettes )[ i ];
+  return ( (const uint32_t*) etiquettes )[ i ];
+}
+
+/**
+   Remplit les tampons comme le calcul l'aurait fait (étiquettes,
+   sommes, couleurs, table éventuelle) et repeint \a output. Rend FALSE,
+   sans toucher \a output, si une étiquette n'est pas sous \a nb (fichier
+   abîmé): ce n'est alors qu'un échec.
+*/
+static bool restaurer( Image* output, Tampons* tampons, const unsigned char* etiquettes, int octets,
+                       uint32_t nb, const SommeCouleur* sommes )
+{
+  uint32_t taille = (uint32_t) output->width * output->height;
+  preparerTampons( tampons, taille );
+  bool valides = TRUE;
+  for ( uint32_t i = 0; i < taille; ++i )
+  {
+    tampons->etiquettes[ i ] = lireEtiquette( etiquettes, octets, i );
+    valides &= tampons->etiquettes[ i ] < nb;
+  }
+  if ( ! valides ) return FALSE;
+  memcpy( tampons->sommes, sommes, nb * sizeof( SommeCouleur ) );
+  moyennerComposantes( tampons, nb );
+  peindreComposantes( output, tampons, 0, output->height );
+  TableComposantes* table = tampons->table;
+  if ( table != NULL )
+  { // Les étiquettes apparaissent dans l'ordre de lecture, comme pendant le calcul.
+    commencerTable( table, output->width, output->height );
+    uint32_t nb_vues = 0, i = 0;
+    for ( int y = 0; y < output->height; ++y )
+      for ( int x = 0; x < output->width; ++x, ++i )
+      {
+        uint32_t e = tampons->etiquettes[ i ];
+        if ( e == nb_vues )
+        {
+          ajouterComposante( table, x, y );
+          nb_vues++;
+        }
+        mesurerPixel( table, tampons->etiquettes, e, x, y, i );
+      }
+    terminerTable( table, tampons->etiquettes, tampons->couleurs );
+  }
+  return TRUE;
+}
+
+static void cheminFichier( const Cache* cache, const CleCache* cle, char* chemin, size_t n )
+{
+  snprintf( chemin, n, "%s/%016llx%016llx.ufc", cache->dossier,
+            (unsigned long long) cle->h[ 0 ], (unsigned long long) cle->h[ 1 ] );
+}
+
+static size_t octetsEtiquettes( const EntreeCache* entree )
+{
+  return (size_t) entree->width * entree->height * entree->octets;
+}
+
+/**
+   Écrit \a entree dans le dossier: dans un fichier temporaire, renommé
+   une fois complet, pour qu'un autre processus ne lise jamais un
+   fichier à moitié écrit. Appelée sans le verrou: les étiquettes et
+   les sommes d'une entrée ne changent plus. Rend TRUE si le fichier a
+   été écrit.
+*/
+static bool ecrireEntree( const Cache* cache, EntreeCache* entree )
+{
+  if ( cache->dossier == NULL || entree->sur_disque ) return FALSE;
+  char chemin[ 4096 ], temporaire[ 4096 ];
+  cheminFichier( cache, &entree->cle, chemin, sizeof( chemin ) );
+  snprintf( temporaire, sizeof( temporaire ), "%s/.ecriture-XXXXXX", cache->dossier );
+  int fd = mkstemp( temporaire );
+  if ( fd < 0 ) return FALSE;
+  FILE* f = fdopen( fd, "wb" );
+  if ( f == NULL )
+  {
+    close( fd );
+    unlink( temporaire );
+    return FALSE;
+  }
+  EnteteCache entete;
+  memcpy( entete.magie, MAGIE_CACHE, 8 );
+  entete.cle = entree->cle;
+  entete.width = entree->width;
+  entete.height = entree->height;
+  entete.nb = entree->nb;
+  entete.octets = entree->octets;
+  // Les sommes commencent à un multiple de 8 octets.
+  static const unsigned char zeros[ 8 ] = { 0 };
+  size_t n = octetsEtiquettes( entree );
+  bool ok = fwrite( &entete, sizeof( entete ), 1, f ) == 1
+    && fwrite( entree->etiquettes, 1, n, f ) == n
+    && fwrite( zeros, 1, ( 8 - n % 8 ) % 8, f ) == ( 8 - n % 8 ) % 8
+    && fwrite( entree->sommes, sizeof( SommeCouleur ), entree->nb, f ) == entree->nb;
+  ok = fclose( f ) == 0 && ok;
+  if ( ok && rename( temporaire, chemin ) == 0 )
+  {
+    entree->sur_disque = TRUE;
+    return TRUE;
+  }
+  unlink( temporaire );
+  return FALSE;
+}
+
+static void detacher( Cache* cache, EntreeCache* entree )
+{
+  if ( entree->precedente != NULL ) entree->precedente->suivante = entree->suivante;
+  else cache->premiere = entree->suivante;
+  if ( entree->suivante != NULL ) entree->suivante->precedente = entree->precedente;
+  else cache->derniere = entree->precedente;
+}
+
+static void placerEnTete( Cache* cache, EntreeCache* entree )
+{
+  entree->precedente = NULL;
+  entree->suivante = cache->premiere;
+  if ( cache->premiere != NULL ) cache->premiere->precedente = entree;
+  cache->premiere = entree;
+  if ( cache->derniere == NULL ) cache->derniere = entree;
+}
+
+static void libererEntree( EntreeCache* entree )
+{
+  free( entree->etiquettes );
+  free( entree->sommes );
+  free( entree );
+}
+
+static EntreeCache* trouverEntree( const Cache* cache, const CleCache* cle )
+{
+  EntreeCache* entree = cache->premiere;
+  while ( entree != NULL && ( entree->cle.h[ 0 ] != cle->h[ 0 ] || entree->cle.h[ 1 ] != cle->h[ 1 ] ) )
+    entree = entree->suivante;
+  return entree;
+}
+
+/// Rend une référence sur \a entree, sans le verrou; la dernière la libère.
+static void relacher( Cache* cache, EntreeCache* entree )
+{
+  pthread_mutex_lock( &cache->verrou );
+  bool derniere = --entree->references == 0;
+  pthread_mutex_unlock( &cache->verrou );
+  if ( derniere ) libererEntree( entree );
+}
+
+/**
+   Ajoute \a entree en tête de la liste (verrou tenu), après en avoir
+   sorti assez d'anciennes entrées, et rend TRUE. Les entrées sorties
+   sont chaînées dans *\a sorties, à passer à sortir une fois le verrou
+   rendu; une entrée plus grosse que toute la mémoire y va directement.
+   Rend FALSE, sans rien changer, si la clé est déjà en mémoire (deux
+   threads ont calculé la même image): l'appelant libère \a entree.
+*/
+static bool inserer( Cache* cache, EntreeCache* entree, EntreeCache** sorties )
+{
+  if ( trouverEntree( cache, &entree->cle ) != NULL ) return FALSE;
+  if ( entree->taille > cache->capacite )
+  {
+    entree->suivante = *sorties;
+    *sorties = entree;
+    return TRUE;
+  }
+  while ( cache->stats.octets + entree->taille > cache->capacite )
+  {
+    EntreeCache* derniere = cache->derniere;
+    detacher( cache, derniere );
+    cache->stats.octets -= derniere->taille;
+    cache->stats.nb_entrees--;
+    cache->stats.evictions++;
+    derniere->suivante = *sorties;
+    *sorties = derniere;
+  }
+  placerEnTete( cache, entree );
+  cache->stats.octets += entree->taille;
+  cache->stats.nb_entrees++;
+  return TRUE;
+}
+
+/**
+   Écrit sur disque au besoin, sans le verrou, les entrées sorties de
+   la mémoire par inserer, puis rend leur référence: une lecture encore
+   en cours garde l'entrée jusqu'à sa fin.
+*/
+static void sortir( Cache* cache, EntreeCache* sorties )
+{
+  uint64_t ecrites = 0;
+  while ( sorties != NULL )
+  {
+    EntreeCache* suivante = sorties->suivante;
+    if ( ecrireEntree( cache, sorties ) ) ecrites++;
+    relacher( cache, sorties );
+    sorties = suivante;
+  }
+  if ( ecrites == 0 ) return;
+  pthread_mutex_lock( &cache->verrou );
+  cache->stats.ecritures += ecrites;
+  pthread_mutex_unlock( &cache->verrou );
+}
+
+/// Range \a entree, en prenant puis rendant le verrou.
+static void ranger( Cache* cache, EntreeCache* entree )
+{
+  EntreeCache* sorties = NULL;
+  pthread_mutex_lock( &cache->verrou );
+  bool gardee = inserer( cache, entree, &sorties );
+  pthread_mutex_unlock( &cache->verrou );
+  if ( ! gardee ) libererEntree( entree );
+  sortir( cache, sorties );
+}
+
+static EntreeCache* creerEntree( const CleCache* cle, int width, int height, uint32_t nb )
+{
+  EntreeCache* entree = (EntreeCache*) calloc( 1, sizeof( EntreeCache ) );
+  entree->cle = *cle;
+  entree->width = width;
+  entree->height = height;
+  entree->nb = nb;
+  entree->octets = nb <= 0x100 ? 1 : nb <= 0x10000 ? 2 : 4;
+  entree->etiquettes = (unsigned char*) malloc( octetsEtiquettes( entree ) );
+  entree->sommes = (SommeCouleur*) malloc( nb * sizeof( SommeCouleur ) );
+  entree->taille = sizeof( EntreeCache ) + octetsEtiquettes( entree ) + nb * sizeof( SommeCouleur );
+  entree->references = 1;
+  return entree;
+}
+
+/**
+   Cherche \a cle dans le fichier du dossier, sans le verrou. S'il
+   existe, le projette en mémoire, restaure le résultat dans \a output
+   et \a tampons, et le garde en mémoire pour la prochaine fois.
+*/
+static bool chercherDisque( Cache* cache, const CleCache* cle, Image* output, Tampons* tampons )
+{
+  if ( cache->dossier == NULL ) return FALSE;
+  char chemin[ 4096 ];
+  cheminFichier( cache, cle, chemin, sizeof( chemin ) );
+  int fd = open( chemin, O_RDONLY );
+  if ( fd < 0 ) return FALSE;
+  struct stat st;
+  void* projection = MAP_FAILED;
+  if ( fstat( fd, &st ) == 0 && (size_t) st.st_size >= sizeof( EnteteCache ) )
+    projection = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if ( projection == MAP_FAILED ) return FALSE;
+
+  const EnteteCache* entete = (const EnteteCache*) projection;
+  size_t n = (size_t) output->width * output->height * entete->octets;
+  size_t debut_sommes = sizeof( EnteteCache ) + n + ( 8 - n % 8 ) % 8;
+  bool valide = memcmp( entete->magie, MAGIE_CACHE, 8 ) == 0
+    && entete->cle.h[ 0 ] == cle->h[ 0 ] && entete->cle.h[ 1 ] == cle->h[ 1 ]
+    && entete->width == output->width && entete->height == output->height
+    && entete->nb >= 1 && entete->nb <= (uint32_t) output->width * output->height
+    && entete->octets == (uint32_t) ( entete->nb <= 0x100 ? 1 : entete->nb <= 0x10000 ? 2 : 4 )
+    && (size_t) st.st_size == debut_sommes + (size_t) entete->nb * sizeof( SommeCouleur );
+  const unsigned char* etiquettes = (const unsigned char*) projection + sizeof( EnteteCache );
+  const SommeCouleur* sommes = (const SommeCouleur*) ( (const unsigned char*) projection + debut_sommes );
+  valide = valide && restaurer( output, tampons, etiquettes, entete->octets, entete->nb, sommes );
+  EntreeCache* entree = NULL;
+  if ( valide )
+  {
+    entree = creerEntree( cle, output->width, output->height, entete->nb );
+    memcpy( entree->etiquettes, etiquettes, n );
+    memcpy( entree->sommes, sommes, entete->nb * sizeof( SommeCouleur ) );
+    entree->sur_disque = TRUE;
+  }
+  munmap( projection, st.st_size );
+  if ( entree != NULL ) ranger( cache, entree );
+  return valide;
+}
+
+//-----------------------------------------------------------------------------
+// Cache
+//-----------------------------------------------------------------------------
+/**
+   Crée un cache d'au plus \a capacite octets en mémoire, qui déborde
+   dans le dossier \a dossier (créé au besoin), ou nulle part si
+   \a dossier est NULL.
+*/
+Cache* creerCache( size_t capacite, const char* dossier )
+{
+  Cache* cache = (Cache*) calloc( 1, sizeof( Cache ) );
+  cache->capacite = capacite;
+  if ( dossier != NULL )
+  {
+    mkdir( dossier, 0777 );
+    cache->dossier = strdup( dossier );
+  }
+  pthread_mutex_init( &cache->verrou, NULL );
+  return cache;
+}
+
+/**
+   Écrit dans le dossier les résultats encore en mémoire, puis libère
+   tout. Plus aucun thread ne doit utiliser \a cache.
+*/
+void libererCache( Cache* cache )
+{
+  if ( cache == NULL ) return;
+  while ( cache->premiere != NULL )
+  {
+    EntreeCache* entree = cache->premiere;
+    detacher( cache, entree );
+    ecrireEntree( cache, entree );
+    libererEntree( entree );
+  }
+  pthread_mutex_destroy( &cache->verrou );
+  free( cache->dossier );
+  free( cache );
+}
+
+/**
+   Si le résultat de \a cle est connu (en mémoire ou dans le dossier),
+   repeint \a output et remplit \a tampons comme l'aurait fait le
+   calcul, et rend TRUE.
+*/
+bool chercherCache( Cache* cache, const CleCache* cle, Image* output, Tampons* tampons )
+{
+  // Sous le verrou, on ne fait que trouver l'entrée et la garder
+  // (référence) le temps de la repeindre.
+  pthread_mutex_lock( &cache->verrou );
+  EntreeCache* entree = trouverEntree( cache, cle );
+  if ( entree != NULL && entree->width == output->width && entree->height == output->height )
+  {
+    detacher( cache, entree );
+    placerEnTete( cache, entree );
+    entree->references++;
+  }
+  else
+    entree = NULL;
+  pthread_mutex_unlock( &cache->verrou );
+
+  bool trouve;
+  if ( entree != NULL )
+  {
+    trouve = restaurer( output, tampons, entree->etiquettes, entree->octets, entree->nb, entree->sommes );
+    relacher( cache, entree );
+  }
+  else
+    trouve = chercherDisque( cache, cle, output, tampons );
+  pthread_mutex_lock( &cache->verrou );
+  if ( ! trouve ) cache->stats.echecs++;
+  else if ( entree != NULL ) cache->stats.succes_memoire++;
+  else cache->stats.succes_disque++;
+  pthread_mutex_unlock( &cache->verrou );
+  return trouve;
+}
+
+/**
+   Garde le résultat que le dernier calcul a laissé dans \a tampons
+   (étiquettes compactes et sommes des couleurs d'une image \a width x
+   \a height), sous la clé \a cle.
+*/
+void rangerCache( Cache* cache, const CleCache* cle, const Tampons* tampons, int width, int height )
+{
+  uint32_t taille = (uint32_t) width * height;
+  uint32_t nb = 0;
+  for ( uint32_t i = 0; i < taille; ++i )
+    if ( tampons->etiquettes[ i ] >= nb ) nb = tampons->etiquettes[ i ] + 1;
+  EntreeCache* entree = creerEntree( cle, width, height, nb );
+  for ( uint32_t i = 0; i < taille; ++i )
+    if ( entree->octets == 1 ) entree->etiquettes[ i ] = tampons->etiquettes[ i ];
+    else if ( entree->octets == 2 ) ( (uint16_t*) entree->etiquettes )[ i ] = tampons->etiquettes[ i ];
+    else ( (uint32_t*) entree->etiquettes )[ i ] = tampons->etiquettes[ i ];
+  memcpy( entree->sommes, tampons->sommes, nb * sizeof( SommeCouleur ) );
+  ranger( cache, entree );
+}
+
+StatsCache statistiquesCache( Cache* cache )
+{
+  pthread_mutex_lock( &cache->verrou );
+  StatsCache stats = cache->stats;
+  pthread_mutex_unlock( &cache->verrou );
+  return stats;
+}
+
+/// Écrit les compteurs de \a cache sur une ligne de \a f.
+void ecrireStatsCache( Cache* cache, FILE* f )
+{
+  StatsCache s = statistiquesCache( cache );
+  fprintf( f, "cache: %llu succes (%llu en memoire, %llu sur disque), %llu echecs,"
+           " %u resultats en memoire (%.1f Mo), %llu evictions, %llu fichiers ecrits\n",
+           (unsigned long long) ( s.succes_memoire + s.succes_disque ),
+           (unsigned long long) s.succes_memoire, (unsigned long long) s.succes_disque,
+           (unsigned long long) s.echecs, s.nb_entrees, s.octets / 1048576.0,
+           (unsigned long long) s.evictions, (unsigned long long) s.ecritures );
+}
+
+//-----------------------------------------------------------------------------
+// Calculs avec cache
+//-----------------------------------------------------------------------------
+/**
+   Comme calculerComposantesConnexesTampons, en passant par \a cache
+   (NULL: sans cache). Le moteur par plages ne laisse pas d'étiquettes
+   dans les tampons sans table des composantes: son résultat n'est
+   alors pas gardé, mais il peut être servi par le cache.
+*/
+bool calculerComposantesConnexesCache( Cache* cache, const Image* input, Image* output,
+                                       Tampons* tampons )
+{
+  if ( cache == NULL )
+    return calculerComposantesConnexesTampons( input, output, tampons );
+  if ( ! annoncerPhase( tampons, AVANCEMENT_EMPREINTE ) ) return FALSE;
+  CleCache cle = cleCache( RESULTAT_COMPOSANTES, 0.0, input, output );
+  if ( chercherCache( cache, &cle, output, tampons ) )
+  {
+    annoncerPhase( tampons, AVANCEMENT_FINI );
+    return TRUE;
+  }
+  if ( ! calculerComposantesConnexesTampons( input, output, tampons ) ) return FALSE;
+  if ( moteurComposantesChoisi() == COMPOSANTES_PAR_PIXELS || tampons->table != NULL )
+    rangerCache( cache, &cle, tampons, output->width, output->height );
+  return TRUE;
+}
+
+/**
+   Comme calculerComposantesConnexesFlouesPlans, en passant par
+   \a cache (NULL: sans cache). Les plans TSV de \a input ne sont
+   calculés (dans *\a plans, s'il est NULL) qu'en cas d'échec, après
+   \a avant (s'il n'est pas NULL) qui peut interrompre le calcul.
+*/
+bool calculerComposantesConnexesFlouesCache( Cache* cache, const Image* input, Image* output,
+                                             PlansTSV** plans, double floue, Tampons* tampons,
+                                             AvantCalculCache avant, void* data )
+{
+  CleCache cle;
+  if ( cache != NULL )
+  {
+    if ( ! annoncerPhase( tampons, AVANCEMENT_EMPREINTE ) ) return FALSE;
+    cle = cleCache( RESULTAT_FLOUES, floue, input, NULL );
+    if ( chercherCache( cache, &cle, output, tampons ) )
+    {
+      annoncerPhase( tampons, AVANCEMENT_FINI );
+      return TRUE;
+    }
+  }
+  if ( avant != NULL && ! avant( input, floue, tampons, data ) ) return FALSE;
+  if ( *plans == NULL ) *plans = creerPlansTSV( input );
+  if ( ! calculerComposantesConnexesFlouesPlans( input, output, *plans, floue, tampons ) ) return FALSE;
+  if ( cache != NULL )
+    rangerCache( cache, &cle, tampons, output->width, output->height );
+  return TRUE;
+}
+
+/// Comme calculerComposantesConnexesFlouesCache, pour calculerComposantesAdaptatives.
+bool calculerComposantesAdaptativesCache( Cache* cache, const Image* input, Image* output,
+                                          PlansTSV** plans, double k, Tampons* tampons )
+{
+  CleCache cle;
+  if ( cache != NULL )
+  {
+    if ( ! annoncerPhase( tampons, AVANCEMENT_EMPREINTE ) ) return FALSE;
+    cle = cleCache( RESULTAT_ADAPTATIVES, k, input, NULL );
+    if ( chercherCache( cache, &cle, output, tampons ) )
+    {
+      annoncerPhase( tampons, AVANCEMENT_FINI );
+      return TRUE;
+    }
+  }
+  if ( *plans == NULL ) *plans = creerPlansTSV( input );
+  if ( ! calculerComposantesAdaptatives( input, output, *plans, k, tampons ) ) return FALSE;
+  if ( cache != NULL )
+    rangerCache( cache, &cle, tampons, output->width, output->height );
+  return TRUE;
+}
@@ -0,0 +1,102 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+/**
+   Cache des résultats de segmentation, indexé par le contenu des images.
+
+   La clé d'un résultat est une empreinte de 128 bits des pixels (de
+   l'entrée, et de la sortie seuillée pour les composantes de même
+   gris), de la taille et du format de l'image, de l'opération, de son
+   paramètre (floue, k) et de la connexité. La même image segmentée
+   avec les mêmes réglages retrouve donc son résultat sans refaire les
+   unions: seuls les pixels sont relus (empreinte), puis repeints.
+
+   Un résultat est gardé sous forme compacte: l'étiquette de chaque
+   pixel, sur 1, 2 ou 4 octets selon le nombre de composantes, et les
+   sommes des couleurs de chaque composante. C'est ce que laisse un
+   calcul dans les tampons (tampons.h): après un succès, les tampons
+   sont remplis comme par le calcul, et --merge ou la table des
+   composantes s'appliquent de même.
+
+   En mémoire, les résultats les plus récemment utilisés sont gardés
+   dans la limite de \a capacite octets. Les plus anciens sont écrits,
+   si un dossier est donné, dans un fichier par résultat, qui est
+   projeté en mémoire (mmap) quand on le redemande; libererCache y
+   écrit aussi ceux qui restent en mémoire. Les fichiers sont propres à
+   la machine (entiers dans son ordre d'octets); on peut vider le
+   dossier à tout moment. Une collision d'empreintes de 128 bits
+   rendrait un résultat faux: on la néglige.
+
+   Un Cache peut être partagé par plusieurs threads. Le verrou ne
+   protège que la liste et les compteurs: repeindre un résultat, lire
+   ou écrire un fichier se fait sans lui.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "segmentation.h"
+#include "plans-tsv.h"
+#include "tampons.h"
+
+/// Capacité en mémoire par défaut, en octets.
+#define CAPACITE_CACHE_DEFAUT ( (size_t) 256 << 20 )
+
+/// Opérations dont le résultat est gardé.
+typedef enum {
+  RESULTAT_COMPOSANTES,
+  RESULTAT_FLOUES,
+  RESULTAT_ADAPTATIVES
+} TypeResultat;
+
+typedef struct {
+  uint64_t h[ 2 ];
+} CleCache;
+
+/// Compteurs du cache, depuis sa création.
+typedef struct {
+  uint64_t succes_memoire;
+  uint64_t succes_disque;
+  uint64_t echecs;
+  uint64_t evictions;   // résultats sortis de la mémoire
+  uint64_t ecritures;   // fichiers écrits dans le dossier
+  size_t octets;        // occupés en mémoire
+  uint32_t nb_entrees;  // résultats en mémoire
+} StatsCache;
+
+typedef struct EntreeCache EntreeCache;
+
+typedef struct {
+  size_t capacite;       // octets au plus en mémoire
+  char* dossier;         // NULL: pas de fichiers
+  EntreeCache* premiere; // la plus récemment utilisée
+  EntreeCache* derniere; // la prochaine à sortir
+  StatsCache stats;
+  pthread_mutex_t verrou;
+} Cache;
+
+/**
+   Appelée par calculerComposantesConnexesFlouesCache juste avant de
+   calculer (pas de cache, ou résultat absent), depuis le thread du
+   calcul: par exemple pour envoyer des aperçus. Rend FALSE pour
+   interrompre le calcul.
+*/
+typedef bool (*AvantCalculCache)( const Image* input, double floue, Tampons* tampons, void* data );
+
+Cache* creerCache( size_t capacite, const char* dossier );
+void libererCache( Cache* cache );
+CleCache cleCache( TypeResultat type, double parametre, const Image* input, const Image* output );
+bool chercherCache( Cache* cache, const CleCache* cle, Image* output, Tampons* tampons );
+void rangerCache( Cache* cache, const CleCache* cle, const Tampons* tampons, int width, int height );
+StatsCache statistiquesCache( Cache* cache );
+void ecrireStatsCache( Cache* cache, FILE* f );
+
+bool calculerComposantesConnexesCache( Cache* cache, const Image* input, Image* output,
+                                       Tampons* tampons );
+bool calculerComposantesConnexesFlouesCache( Cache* cache, const Image* input, Image* output,
+                                             PlansTSV** plans, double floue, Tampons* tampons,
+                                             AvantCalculCache avant, void* data );
+bool calculerComposantesAdaptativesCache( Cache* cache, const Image* input, Image* output,
+                                          PlansTSV** plans, double k, Tampons* tampons );
+
+#endif
@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "composantes.h"
+
+TableComposantes* creerTable( void )
+{
+  return (TableComposantes*) calloc( 1, sizeof( TableComposantes ) );
+}
+
+void libererTable( TableComposantes* table )
+{
+  if ( table == NULL ) return;
+  free( table->composantes );
+  free( table->etiquettes );
+  free( table );
+}
+
+/**
+   Vide \a table pour une image \a width x \a height. Les tableaux ne
+   sont réalloués que s'ils sont trop petits.
+*/
+void commencerTable( TableComposantes* table, int width, int height )
+{
+  size_t taille = (size_t) width * height;
+  if ( taille > (size_t) table->width * table->height || table->etiquettes == NULL )
+  {
+    free( table->etiquettes );
+    table->etiquettes = (uint32_t*) malloc( taille * sizeof( uint32_t ) );
+  }
+  table->width = width;
+  table->height = height;
+  table->nb = 0;
+}
+
+/**
+   Nouvelle composante, d'étiquette table->nb, dont le premier pixel
+   (dans l'ordre de lecture) est ( \a x, \a y ).
+*/
+void ajouterComposante( TableComposantes* table, int x, int y )
+{
+  if ( table->nb == table->capacite )
+  {
+    table->capacite = table->capacite == 0 ? 1024 : 2 * table->capacite;
+    table->composantes = (Composante*) realloc( table->composantes,
+                                                table->capacite * sizeof( Composante ) );
+  }
+  Composante* c = &table->composantes[ table->nb++ ];
+  memset( c, 0, sizeof( Composante ) );
+  c->x0 = c->x1 = x;
+  c->y0 = c->y1 = y;
+}
+
+/**
+   Termine la table après le parcours: copie l'image des \a etiquettes,
+   calcule les centres de gravité et range les \a couleurs moyennes.
+*/
+void terminerTable( TableComposantes* table, const uint32_t* etiquettes, const Pixel* couleurs )
+{
+  memcpy( table->etiquettes, etiquettes, (size_t) table->width * table->height * sizeof( uint32_t ) );
+  for ( uint32_t e = 0; e < table->nb; ++e )
+  {
+    Composante* c = &table->composantes[ e ];
+    c->cx = (double) c->somme_x / c->aire;
+    c->cy = (double) c->somme_y / c->aire;
+    c->couleur = couleurs[ e ];
+    c->tsv = tsv( &c->couleur );
+  }
+}
+
+/**
+   Écarte les composantes de moins de \a aire_min pixels: les autres
+   sont renumérotées dans le même ordre, et les pixels des composantes
+   écartées reçoivent COMPOSANTE_FILTREE. Rend le nombre de composantes
+   gardées.
+*/
+uint32_t filtrerComposantes( TableComposantes* table, uint32_t aire_min )
+{
+  uint32_t* nouvelle = (uint32_t*) malloc( ( table->nb + 1 ) * sizeof( uint32_t ) );
+  uint32_t nb = 0;
+  for ( uint32_t e = 0; e < table->nb; ++e )
+    if ( table->composantes[ e ].aire >= aire_min )
+    {
+      table->composantes[ nb ] = table->composantes[ e ];
+      nouvelle[ e ] = nb++;
+    }
+    else
+      nouvelle[ e ] = COMPOSANTE_FILTREE;
+  size_t taille = (size_t) table->width * table->height;
+  for ( size_t i = 0; i < taille; ++i )
+    if ( table->etiquettes[ i ] != COMPOSANTE_FILTREE )
+      table->etiquettes[ i ] = nouvelle[ table->etiquettes[ i ] ];
+  free( nouvelle );
+  table->nb = nb;
+  return nb;
+}
+
+/**
+   Une ligne par composante, dans l'ordre des étiquettes.
+*/
+void ecrireTableCSV( const TableComposantes* table, FILE* f )
+{
+  fprintf( f, "etiquette,aire,x0,y0,x1,y1,cx,cy,rouge,vert,bleu,teinte,saturation,valeur,perimetre\n" );
+  for ( uint32_t e = 0; e < table->nb; ++e )
+  {
+    const Composante* c = &table->composantes[ e ];
+    fprintf( f, "%u,%u,%d,%d,%d,%d,%.3f,%.3f,%d,%d,%d,%d,%g,%g,%u\n",
+             e, c->aire, c->x0, c->y0, c->x1, c->y1, c->cx, c->cy,
+             c->couleur.rouge, c->couleur.vert, c->couleur.bleu,
+             c->tsv.t, c->tsv.s, c->tsv.v, c->perimetre );
+  }
+}
+
+/**
+   Format binaire, entiers et flottants dans l'ordre des octets de la
+   machine:
+     "UFCT", version (u32, 1), width (i32), height (i32), nb (u32),
+     nb enregistrements de 56 octets:
+       aire (u32), x0 y0 x1 y1 (i32), cx cy (f64), rouge vert bleu (u8),
+       un octet nul, teinte (i32), saturation valeur (f32), perimetre (u32),
+     puis width * height étiquettes (u32, COMPOSANTE_FILTREE pour un pixel écarté).
+*/
+void ecrireTableBinaire( const TableComposantes* table, FILE* f )
+{
+  uint32_t entete[ 4 ] = { 1, (uint32_t) table->width, (uint32_t) table->height, table->nb };
+  fwrite( "UFCT", 1, 4, f );
+  fwrite( entete, sizeof( uint32_t ), 4, f );
+  for ( uint32_t e = 0; e < table->nb; ++e )
+  {
+    const Composante* c = &table->composantes[ e ];
+    int32_t boite[ 4 ] = { c->x0, c->y0, c->x1, c->y1 };
+    double centre[ 2 ] = { c->cx, c->cy };
+    uint8_t couleur[ 4 ] = { c->couleur.rouge, c->couleur.vert, c->couleur.bleu, 0 };
+    int32_t teinte = c->tsv.t;
+    float sv[ 2 ] = { (float) c->tsv.s, (float) c->tsv.v };
+    fwrite( &c->aire, sizeof( uint32_t ), 1, f );
+    fwrite( boite, sizeof( int32_t ), 4, f );
+    fwrite( centre, sizeof( double ), 2, f );
+    fwrite( couleur, 1, 4, f );
+    fwrite( &teinte, sizeof( int32_t ), 1, f );
+    fwrite( sv, sizeof( float ), 2, f );
+    fwrite( &c->perimetre, sizeof( uint32_t ), 1, f );
+  }
+  fwrite( table->etiquettes, sizeof( uint32_t ), (size_t) table->width * table->height, f );
+}
+
+/**
+   Écrit la table dans \a filename: en binaire si son extension est
+   .bin, en CSV sinon. Rend FALSE en cas d'erreur.
+*/
+bool ecrireTable( const TableComposantes* table, const char* filename )
+{
+  const char* ext = strrchr( filename, '.' );
+  bool binaire = ext != NULL && strcasecmp( ext, ".bin" ) == 0;
+  FILE* f = fopen( filename, binaire ? "wb" : "w" );
+  if ( f == NULL ) return FALSE;
+  if ( binaire ) ecrireTableBinaire( table, f );
+  else           ecrireTableCSV( table, f );
+  return fclose( f ) == 0;
+}
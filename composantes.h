@@ -0,0 +1,77 @@
+#ifndef COMPOSANTES_H
+#define COMPOSANTES_H
+
+/**
+   Table des composantes: image des étiquettes, et pour chaque
+   composante son aire, sa boîte englobante, son centre de gravité, sa
+   couleur moyenne (RGB et TSV) et son périmètre.
+
+   La table se remplit pendant le parcours qui somme les couleurs
+   (sommerComposantes, voir mesurerTampons dans tampons.h): il n'y a pas
+   de parcours de plus de l'image. On peut ensuite écarter les petites
+   composantes et exporter la table en CSV ou en binaire.
+
+   Le périmètre est le nombre de côtés de pixels qui séparent la
+   composante du reste de l'image ou du bord (4-voisinage, quelle que
+   soit la connexité des composantes).
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include "segmentation.h"
+
+/// Étiquette des pixels d'une composante écartée par filtrerComposantes.
+#define COMPOSANTE_FILTREE UINT32_MAX
+
+typedef struct {
+  uint32_t aire;       // nombre de pixels
+  int x0, y0, x1, y1;  // boîte englobante, bornes comprises
+  double cx, cy;       // centre de gravité
+  Pixel couleur;       // couleur moyenne (tronquée, celle du recoloriage)
+  TSVCouleur tsv;      // tsv() de la couleur moyenne
+  uint32_t perimetre;
+  uint64_t somme_x;    // sommes des coordonnées, pour le centre de gravité
+  uint64_t somme_y;
+} Composante;
+
+typedef struct TableComposantes {
+  int width;
+  int height;
+  uint32_t nb;
+  uint32_t capacite;
+  Composante* composantes; // indexées par étiquette
+  uint32_t* etiquettes;    // étiquette de chaque pixel, ligne par ligne
+} TableComposantes;
+
+TableComposantes* creerTable( void );
+void libererTable( TableComposantes* table );
+void commencerTable( TableComposantes* table, int width, int height );
+void ajouterComposante( TableComposantes* table, int x, int y );
+void terminerTable( TableComposantes* table, const uint32_t* etiquettes, const Pixel* couleurs );
+uint32_t filtrerComposantes( TableComposantes* table, uint32_t aire_min );
+void ecrireTableCSV( const TableComposantes* table, FILE* f );
+void ecrireTableBinaire( const TableComposantes* table, FILE* f );
+bool ecrireTable( const TableComposantes* table, const char* filename );
+
+/**
+   Ajoute le pixel ( \a x, \a y ), d'indice \a i et d'étiquette \a e, à
+   sa composante. Les étiquettes des pixels de gauche et du dessus
+   doivent être déjà dans \a etiquettes: chaque côté commun à deux
+   pixels de la composante retire 2 aux 4 côtés comptés par pixel.
+*/
+static inline void mesurerPixel( TableComposantes* table, const uint32_t* etiquettes,
+                                 uint32_t e, int x, int y, uint32_t i )
+{
+  Composante* c = &table->composantes[ e ];
+  c->aire += 1;
+  if ( x < c->x0 ) c->x0 = x;
+  if ( x > c->x1 ) c->x1 = x;
+  if ( y > c->y1 ) c->y1 = y; // y0 est la ligne où la composante apparaît
+  c->somme_x += x;
+  c->somme_y += y;
+  c->perimetre += 4;
+  if ( x > 0 && etiquettes[ i - 1 ] == e ) c->perimetre -= 2;
+  if ( y > 0 && etiquettes[ i - table->width ] == e ) c->perimetre -= 2;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include <stdlib.h>
+#include "file-bornee.h"
+
+FileBornee* creerFile( int capacite )
+{
+  FileBornee* file = (FileBornee*) calloc( 1, sizeof( FileBornee ) );
+  file->capacite = capacite > 0 ? capacite : 1;
+  file->elements = (void**) malloc( file->capacite * sizeof( void* ) );
+  pthread_mutex_init( &file->verrou, NULL );
+  pthread_cond_init( &file->non_vide, NULL );
+  pthread_cond_init( &file->non_pleine, NULL );
+  return file;
+}
+
+void libererFile( FileBornee* file )
+{
+  if ( file == NULL ) return;
+  pthread_cond_destroy( &file->non_pleine );
+  pthread_cond_destroy( &file->non_vide );
+  pthread_mutex_destroy( &file->verrou );
+  free( file->elements );
+  free( file );
+}
+
+/**
+   Ajoute \a element au bout de la file, après avoir attendu une place
+   libre. Ne pas déposer dans une file fermée.
+*/
+void deposerFile( FileBornee* file, void* element )
+{
+  pthread_mutex_lock( &file->verrou );
+  while ( file->nb == file->capacite )
+    pthread_cond_wait( &file->non_pleine, &file->verrou );
+  file->elements[ ( file->debut + file->nb ) % file->capacite ] = element;
+  file->nb++;
+  pthread_cond_signal( &file->non_vide );
+  pthread_mutex_unlock( &file->verrou );
+}
+
+/**
+   Retire le plus ancien élément, après avoir attendu un dépôt. Rend
+   NULL si la file est fermée et vide.
+*/
+void* retirerFile( FileBornee* file )
+{
+  pthread_mutex_lock( &file->verrou );
+  while ( file->nb == 0 && ! file->fermee )
+    pthread_cond_wait( &file->non_vide, &file->verrou );
+  void* element = NULL;
+  if ( file->nb > 0 )
+  {
+    element = file->elements[ file->debut ];
+    file->debut = ( file->debut + 1 ) % file->capacite;
+    file->nb--;
+    pthread_cond_signal( &file->non_pleine );
+  }
+  pthread_mutex_unlock( &file->verrou );
+  return element;
+}
+
+/**
+   Plus de dépôt: réveille tous les threads qui attendent un élément.
+*/
+void fermerFile( FileBornee* file )
+{
+  pthread_mutex_lock( &file->verrou );
+  file->fermee = 1;
+  pthread_cond_broadcast( &file->non_vide );
+  pthread_mutex_unlock( &file->verrou );
+}
@@ -0,0 +1,31 @@
+#ifndef FILE_BORNEE_H
+#define FILE_BORNEE_H
+
+/**
+   File de pointeurs bornée, partagée entre threads (pthread). Déposer
+   dans une file pleine attend qu'une place se libère; retirer d'une
+   file vide attend un dépôt, ou la fermeture de la file. Une file
+   fermée ne reçoit plus rien, et rend NULL une fois vidée: c'est le
+   signal de fin pour les threads qui la lisent.
+*/
+
+#include <pthread.h>
+
+typedef struct {
+  void** elements;  // tampon circulaire de capacite éléments
+  int capacite;
+  int debut;        // indice du plus ancien élément
+  int nb;
+  int fermee;       // vrai: plus aucun dépôt
+  pthread_mutex_t verrou;
+  pthread_cond_t non_vide;
+  pthread_cond_t non_pleine;
+} FileBornee;
+
+FileBornee* creerFile( int capacite );
+void libererFile( FileBornee* file );
+void deposerFile( FileBornee* file, void* element );
+void* retirerFile( FileBornee* file );
+void fermerFile( FileBornee* file );
+
+#endif
@@ -0,0 +1,195 @@
+#include <stdlib.h>
+#include "flux.h"
+
+/**
+   Crée un flux pour des lignes de \a width pixels. Avec \a seuil >= 0,
+   les lignes sont seuillées à la volée (comme seuiller()) avant le
+   calcul des composantes. \a emettre est appelée à chaque composante
+   fermée.
+*/
+Flux* creerFlux( int width, int seuil, EmettreComposante emettre, void* data )
+{
+  Flux* flux = (Flux*) calloc( 1, sizeof( Flux ) );
+  // Au plus width plages par ligne, donc 2 * width composantes ouvertes.
+  uint32_t capacite = 2 * (uint32_t) width + 1;
+  flux->width = width;
+  flux->seuil = seuil;
+  flux->precedentes = (Plage*) malloc( width * sizeof( Plage ) );
+  flux->courantes   = (Plage*) malloc( width * sizeof( Plage ) );
+  flux->etiq_prec   = (uint32_t*) malloc( width * sizeof( uint32_t ) );
+  flux->etiq_cour   = (uint32_t*) malloc( width * sizeof( uint32_t ) );
+  flux->foret       = creerForet( capacite );
+  flux->composantes = (ComposanteFlux*) malloc( capacite * sizeof( ComposanteFlux ) );
+  flux->libres      = (uint32_t*) malloc( capacite * sizeof( uint32_t ) );
+  flux->actifs      = (uint32_t*) malloc( capacite * sizeof( uint32_t ) );
+  flux->suivants    = (uint32_t*) malloc( capacite * sizeof( uint32_t ) );
+  flux->vivant      = (unsigned char*) calloc( capacite, 1 );
+  for ( uint32_t k = 0; k < capacite; ++k )
+    flux->libres[ k ] = capacite - 1 - k;
+  flux->nb_libres = capacite;
+  flux->emettre = emettre;
+  flux->data = data;
+  return flux;
+}
+
+/// Gris d'un pixel, seuillé si besoin.
+static inline unsigned char grisFlux( const Flux* flux, const Pixel* pixel )
+{
+  unsigned char g = greyLevel( (Pixel*) pixel );
+  if ( flux->seuil < 0 ) return g;
+  return flux->seuil > g ? 0 : 255;
+}
+
+/// Prend un emplacement libre pour la plage \a p de la ligne courante.
+static uint32_t nouvelleComposante( Flux* flux, const Plage* p, const Pixel* ligne )
+{
+  uint32_t k = flux->libres[ --flux->nb_libres ];
+  flux->foret->pere[ k ] = k;
+  flux->foret->rang[ k ] = 0;
+  ComposanteFlux* c = &flux->composantes[ k ];
+  c->gris = p->gris;
+  c->nb = p->x1 - p->x0;
+  c->rouge = c->vert = c->bleu = 0;
+  for ( int x = p->x0; x < p->x1; ++x )
+  {
+    c->rouge += ligne[ x ].rouge;
+    c->vert  += ligne[ x ].vert;
+    c->bleu  += ligne[ x ].bleu;
+  }
+  c->x0 = p->x0;
+  c->x1 = p->x1 - 1;
+  c->y0 = c->y1 = flux->y;
+  flux->actifs[ flux->nb_actifs++ ] = k;
+  return k;
+}
+
+/// Réunit les composantes \a a et \a b; la racine reçoit leurs statistiques.
+static void unirFlux( Flux* flux, uint32_t a, uint32_t b )
+{
+  uint32_t u = foretTrouver( flux->foret, a );
+  uint32_t v = foretTrouver( flux->foret, b );
+  if ( u == v ) return;
+  foretUnion( flux->foret, u, v );
+  uint32_t r = foretTrouver( flux->foret, u );
+  ComposanteFlux* c = &flux->composantes[ r ];
+  const ComposanteFlux* o = &flux->composantes[ r == u ? v : u ];
+  c->nb    += o->nb;
+  c->rouge += o->rouge;
+  c->vert  += o->vert;
+  c->bleu  += o->bleu;
+  if ( o->x0 < c->x0 ) c->x0 = o->x0;
+  if ( o->x1 > c->x1 ) c->x1 = o->x1;
+  if ( o->y0 < c->y0 ) c->y0 = o->y0;
+  if ( o->y1 > c->y1 ) c->y1 = o->y1;
+}
+
+/**
+   Émet les composantes actives qui ne sont plus prolongées et recycle
+   tous les emplacements qui ne sont pas des racines vivantes.
+*/
+static void fermerComposantes( Flux* flux )
+{
+  uint32_t nb_suivants = 0;
+  for ( uint32_t j = 0; j < flux->nb_actifs; ++j )
+  {
+    uint32_t k = flux->actifs[ j ];
+    if ( flux->vivant[ k ] )
+    {
+      flux->vivant[ k ] = 0;
+      flux->suivants[ nb_suivants++ ] = k;
+      continue;
+    }
+    if ( flux->foret->pere[ k ] == k )
+    {
+      flux->composantes[ k ].numero = flux->nb_emises++;
+      flux->emettre( &flux->composantes[ k ], flux->data );
+    }
+    flux->libres[ flux->nb_libres++ ] = k;
+  }
+  uint32_t* t = flux->actifs;
+  flux->actifs = flux->suivants;
+  flux->suivants = t;
+  flux->nb_actifs = nb_suivants;
+}
+
+/**
+   Ajoute la ligne suivante de l'image (width pixels).
+*/
+void ajouterLigneFlux( Flux* flux, const Pixel* ligne )
+{
+  int width = flux->width;
+  // plages de la ligne, chacune dans une nouvelle composante
+  flux->nb_cour = 0;
+  int x0 = 0;
+  while ( x0 < width )
+  {
+    unsigned char g = grisFlux( flux, &ligne[ x0 ] );
+    int x1 = x0 + 1;
+    while ( x1 < width && grisFlux( flux, &ligne[ x1 ] ) == g )
+      ++x1;
+    Plage* p = &flux->courantes[ flux->nb_cour ];
+    p->x0 = x0;
+    p->x1 = x1;
+    p->gris = g;
+    flux->etiq_cour[ flux->nb_cour ] = nouvelleComposante( flux, p, ligne );
+    ++flux->nb_cour;
+    x0 = x1;
+  }
+
+  // unions avec les plages de la ligne précédente (voir unirPlages)
+  int a = 0, b = 0;
+  while ( a < flux->nb_prec && b < flux->nb_cour )
+  {
+    Plage* pa = &flux->precedentes[ a ];
+    Plage* pb = &flux->courantes[ b ];
+    if ( pa->gris == pb->gris && pa->x0 < pb->x1 && pb->x0 < pa->x1 )
+      unirFlux( flux, flux->etiq_prec[ a ], flux->etiq_cour[ b ] );
+    if ( pa->x1 < pb->x1 ) ++a;
+    else if ( pb->x1 < pa->x1 ) ++b;
+    else { ++a; ++b; }
+  }
+
+  // chaque plage pointe directement sur sa racine, qui reste vivante
+  for ( int j = 0; j < flux->nb_cour; ++j )
+  {
+    uint32_t r = foretTrouver( flux->foret, flux->etiq_cour[ j ] );
+    flux->etiq_cour[ j ] = r;
+    flux->composantes[ r ].y1 = flux->y;
+    flux->vivant[ r ] = 1;
+  }
+  fermerComposantes( flux );
+
+  Plage* p = flux->precedentes;
+  flux->precedentes = flux->courantes;
+  flux->courantes = p;
+  uint32_t* e = flux->etiq_prec;
+  flux->etiq_prec = flux->etiq_cour;
+  flux->etiq_cour = e;
+  flux->nb_prec = flux->nb_cour;
+  flux->y += 1;
+}
+
+/**
+   Fin de l'image: émet les composantes encore ouvertes.
+*/
+void terminerFlux( Flux* flux )
+{
+  fermerComposantes( flux );
+  flux->nb_prec = 0;
+}
+
+void libererFlux( Flux* flux )
+{
+  if ( flux == NULL ) return;
+  free( flux->precedentes );
+  free( flux->courantes );
+  free( flux->etiq_prec );
+  free( flux->etiq_cour );
+  libererForet( flux->foret );
+  free( flux->composantes );
+  free( flux->libres );
+  free( flux->actifs );
+  free( flux->suivants );
+  free( flux->vivant );
+  free( flux );
+}
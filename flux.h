@@ -0,0 +1,64 @@
+#ifndef FLUX_H
+#define FLUX_H
+
+/**
+   Composantes connexes en flux, pour les images plus grandes que la
+   mémoire.
+
+   On donne l'image ligne par ligne. Chaque ligne est codée en plages
+   de même niveau de gris (comme plages.h). Seules deux lignes de
+   plages sont gardées, avec une petite forêt sur les composantes
+   encore ouvertes. Une composante qu'aucune plage de la ligne courante
+   ne prolonge est fermée. On l'émet alors (taille, boîte englobante,
+   somme des couleurs) et on recycle ses emplacements. La mémoire est
+   en O(width), quelle que soit la hauteur, et les tailles sont sur
+   64 bits.
+*/
+
+#include <stdint.h>
+#include "segmentation.h"
+#include "plages.h"
+
+/// Une composante fermée, telle qu'émise par le flux.
+typedef struct {
+  uint64_t numero;  // ordre de fermeture, à partir de 0
+  unsigned char gris;
+  uint64_t nb;      // nombre de pixels
+  uint64_t rouge;   // sommes des couleurs d'entrée
+  uint64_t vert;
+  uint64_t bleu;
+  int x0, x1;       // boîte englobante, bornes incluses
+  int64_t y0, y1;
+} ComposanteFlux;
+
+typedef void (*EmettreComposante)( const ComposanteFlux* composante, void* data );
+
+typedef struct {
+  int width;
+  int seuil;               // seuil de seuiller(), ou -1 pour les gris d'origine
+  int64_t y;               // numéro de la prochaine ligne
+  Plage* precedentes;      // plages de la ligne y - 1
+  uint32_t* etiq_prec;     // leur composante (une racine de la forêt)
+  int nb_prec;
+  Plage* courantes;
+  uint32_t* etiq_cour;
+  int nb_cour;
+  Foret* foret;            // sur les emplacements, 2 * width + 1
+  ComposanteFlux* composantes; // par emplacement, valable pour les racines
+  uint32_t* libres;        // pile des emplacements libres
+  uint32_t nb_libres;
+  uint32_t* actifs;        // emplacements utilisés par les lignes y - 1 et y
+  uint32_t nb_actifs;
+  uint32_t* suivants;      // actifs gardés pour la ligne suivante
+  unsigned char* vivant;   // par emplacement: racine prolongée par la ligne y
+  uint64_t nb_emises;
+  EmettreComposante emettre;
+  void* data;
+} Flux;
+
+Flux* creerFlux( int width, int seuil, EmettreComposante emettre, void* data );
+void ajouterLigneFlux( Flux* flux, const Pixel* ligne );
+void terminerFlux( Flux* flux );
+void libererFlux( Flux* flux );
+
+#endif
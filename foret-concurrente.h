@@ -0,0 +1,83 @@
+#ifndef FORET_CONCURRENTE_H
+#define FORET_CONCURRENTE_H
+
+/**
+   Recherche et union sans verrou sur une Foret partagée par plusieurs
+   threads, qui réunissent chacun n'importe quelles paires d'éléments.
+
+   Chaque case de pere est lue et modifiée de façon atomique (C11). On
+   rattache toujours la racine de plus grand indice à celle de plus
+   petit indice, par un compare-and-swap qui échoue si elle a cessé
+   d'être une racine entre-temps: on recommence alors à partir des
+   racines trouvées. Le rang ne sert pas. Le père d'un élément a donc
+   toujours un indice inférieur ou égal au sien: pas de cycle possible,
+   et la racine d'une composante est son premier pixel dans l'ordre de
+   lecture.
+
+   La compression par demi-chemin est aussi un compare-and-swap, qui
+   n'attend jamais: s'il échoue, un autre thread a déjà raccourci le
+   chemin, et on continue à monter.
+
+   Les composantes ne dépendent que des paires réunies, pas de l'ordre
+   des unions; les étiquettes, données dans l'ordre de lecture (voir
+   sommerComposantes), sont donc celles du calcul séquentiel. Pendant
+   un calcul, ne pas mélanger ces unions et foretUnion sur une même
+   forêt.
+*/
+
+#include <stdatomic.h>
+#include "foret.h"
+
+/// La case pere[ i ], vue comme un entier atomique de même taille.
+static inline _Atomic uint32_t* pereAtomique( Foret* foret, uint32_t i )
+{
+  return (_Atomic uint32_t*) &foret->pere[ i ];
+}
+
+static inline uint32_t foretTrouverConcurrent( Foret* foret, uint32_t i )
+{
+  for ( ;; )
+  {
+    uint32_t p = atomic_load_explicit( pereAtomique( foret, i ), memory_order_relaxed );
+    if ( p == i ) break;
+    uint32_t gp = atomic_load_explicit( pereAtomique( foret, p ), memory_order_relaxed );
+    if ( gp != p )
+      atomic_compare_exchange_weak_explicit( pereAtomique( foret, i ), &p, gp,
+                                             memory_order_relaxed, memory_order_relaxed );
+    i = gp;
+    INSTRUMENTER( compterPas(); )
+  }
+  INSTRUMENTER( compterTrouver(); )
+  return i;
+}
+
+static inline void foretUnionConcurrente( Foret* foret, uint32_t i, uint32_t j )
+{
+  for ( ;; )
+  {
+    uint32_t u = foretTrouverConcurrent( foret, i );
+    uint32_t v = foretTrouverConcurrent( foret, j );
+    if ( u == v )
+    {
+      INSTRUMENTER( compterUnion( 0 ); )
+      return;
+    }
+    if ( u < v )
+    {
+      uint32_t t = u;
+      u = v;
+      v = t;
+    }
+    uint32_t racine = u;
+    if ( atomic_compare_exchange_strong_explicit( pereAtomique( foret, u ), &racine, v,
+                                                  memory_order_relaxed, memory_order_relaxed ) )
+    {
+      INSTRUMENTER( compterUnion( 1 ); )
+      return;
+    }
+    i = u;
+    j = v;
+  }
+}
+
+#endif
@@ -0,0 +1,34 @@
+#include <stdlib.h>
+#include <string.h>
+#include "foret.h"
+
+/**
+   Crée une forêt de \a taille singletons.
+*/
+Foret* creerForet( uint32_t taille )
+{
+  Foret* foret = (Foret*) malloc( sizeof( Foret ) );
+  foret->taille = taille;
+  foret->pere = (uint32_t*) malloc( taille * sizeof( uint32_t ) );
+  foret->rang = (uint8_t*) malloc( taille * sizeof( uint8_t ) );
+  reinitialiserForet( foret );
+  return foret;
+}
+
+/**
+   Remet chaque élément dans son propre ensemble.
+*/
+void reinitialiserForet( Foret* foret )
+{
+  for ( uint32_t i = 0; i < foret->taille; ++i )
+    foret->pere[ i ] = i;
+  memset( foret->rang, 0, foret->taille );
+}
+
+void libererForet( Foret* foret )
+{
+  if ( foret == NULL ) return;
+  free( foret->pere );
+  free( foret->rang );
+  free( foret );
+}
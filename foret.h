@@ -0,0 +1,63 @@
+#ifndef FORET_H
+#define FORET_H
+
+/**
+   Forêt Union-Find compacte, en structure de tableaux: le père de
+   l'élément i est pere[ i ] et son rang rang[ i ]. Pour une image,
+   l'élément i est le pixel ( i % width, i / width ): l'adresse du
+   pixel se déduit de l'indice, il n'y a plus besoin de la stocker.
+
+   5 octets par pixel au lieu des 24 d'un Objet, et les remontées vers
+   la racine parcourent un tableau d'entiers contigus.
+*/
+
+#include <stdint.h>
+#include "instrumentation.h"
+
+typedef struct {
+  uint32_t* pere;
+  uint8_t* rang;   // le rang reste inférieur à log2(taille) <= 32
+  uint32_t taille;
+} Foret;
+
+Foret* creerForet( uint32_t taille );
+void reinitialiserForet( Foret* foret );
+void libererForet( Foret* foret );
+
+/**
+   Trouve la racine de \a i, avec compression par demi-chemin (une seule
+   passe, sans récursion).
+*/
+static inline uint32_t foretTrouver( Foret* foret, uint32_t i )
+{
+  uint32_t* pere = foret->pere;
+  while ( pere[ i ] != i )
+  {
+    pere[ i ] = pere[ pere[ i ] ];
+    i = pere[ i ];
+    INSTRUMENTER( compterPas(); )
+  }
+  INSTRUMENTER( compterTrouver(); )
+  return i;
+}
+
+/**
+   Réunit les ensembles de \a i et \a j (union par rang).
+*/
+static inline void foretUnion( Foret* foret, uint32_t i, uint32_t j )
+{
+  uint32_t u = foretTrouver( foret, i );
+  uint32_t v = foretTrouver( foret, j );
+  INSTRUMENTER( compterUnion( u != v ); )
+  if ( u == v ) return;
+  if ( foret->rang[ u ] > foret->rang[ v ] )
+    foret->pere[ v ] = u;
+  else
+  {
+    foret->pere[ u ] = v;
+    if ( foret->rang[ u ] == foret->rang[ v ] )
+      foret->rang[ v ] += 1;
+  }
+}
+
+#endif
@@ -0,0 +1,280 @@
+#include <stdlib.h>
+#include <string.h>
+#include "gris.h"
+#include "tampons.h"
+
+/// Le gris du pixel x d'une ligne à deux octets par pixel.
+#define GRIS16( ligne, x ) ( ( (ligne)[ 2 * (x) ] << 8 ) | (ligne)[ 2 * (x) + 1 ] )
+
+/// Écrit le gris \a g dans le pixel x d'une ligne à deux octets par pixel.
+static inline void ecrireGris16( unsigned char* ligne, int x, unsigned g )
+{
+  ligne[ 2 * x ] = g >> 8;
+  ligne[ 2 * x + 1 ] = g & 0xff;
+}
+
+/**
+   Seuille \a input dans \a output avec \a nb_seuils seuils, comme
+   seuillerNiveaux (seuillage.h): le gris qui dépasse ou égale j seuils
+   devient j * blanc / nb_seuils, où blanc vaut 255, ou maximum sur 16
+   bits.
+*/
+void seuillerGrisNiveaux( const ImageGrise* input, ImageGrise* output, const int* seuils, int nb_seuils )
+{
+  // Sur 8 bits, le gris écrit pour chaque gris lu.
+  unsigned char table[ 256 ];
+  for ( int g = 0; g < 256; ++g )
+  {
+    int j = 0;
+    for ( int k = 0; k < nb_seuils; ++k )
+      j += ! ( seuils[ k ] > g );
+    table[ g ] = j * 255 / nb_seuils;
+  }
+  for ( int y = 0; y < input->height; ++y )
+  {
+    const unsigned char* in = input->data + (size_t) y * input->rowstride;
+    unsigned char* out = output->data + (size_t) y * output->rowstride;
+    if ( input->octets == 2 )
+      for ( int x = 0; x < input->width; ++x )
+      {
+        // seuil / 255 > g / maximum, en entiers
+        int64_t g = (int64_t) GRIS16( in, x ) * 255;
+        int j = 0;
+        for ( int k = 0; k < nb_seuils; ++k )
+          j += ! ( (int64_t) seuils[ k ] * input->maximum > g );
+        ecrireGris16( out, x, (unsigned) ( (int64_t) j * input->maximum / nb_seuils ) );
+      }
+    else
+      for ( int x = 0; x < input->width; ++x )
+        out[ x ] = table[ in[ x ] ];
+  }
+}
+
+/**
+   Seuille \a input dans \a output: noir en dessous de \a seuil, blanc
+   (255, ou maximum sur 16 bits) sinon.
+*/
+void seuillerGris( const ImageGrise* input, ImageGrise* output, int seuil )
+{
+  seuillerGrisNiveaux( input, output, &seuil, 1 );
+}
+
+/**
+   Les 256 cases de \a histogramme reçoivent le nombre de pixels de
+   chaque gris. Sur 16 bits, le gris g compte pour g * 255 / maximum
+   (arrondi en dessous): g est sous le seuil s exactement quand sa case
+   est sous s, et seuilsOtsu s'applique tel quel.
+*/
+void histogrammeGris( const ImageGrise* input, uint32_t* histogramme )
+{
+  memset( histogramme, 0, 256 * sizeof( uint32_t ) );
+  for ( int y = 0; y < input->height; ++y )
+  {
+    const unsigned char* in = input->data + (size_t) y * input->rowstride;
+    if ( input->octets == 2 )
+      for ( int x = 0; x < input->width; ++x )
+        histogramme[ (int64_t) GRIS16( in, x ) * 255 / input->maximum ]++;
+    else
+      for ( int x = 0; x < input->width; ++x )
+        histogramme[ in[ x ] ]++;
+  }
+}
+
+/// Données des noyaux d'unions sur une image grise (voir noyau-unions.h).
+typedef struct {
+  const ImageGrise* img;
+  int ecart;
+} ContexteGris;
+
+// Les noyaux sont générés pour un et pour deux octets par pixel: GRIS
+// lit un gris.
+#define NOYAU_CONTEXTE ContexteGris
+#define NOYAU_LIGNE( c, y )                                                     \
+  const unsigned char* ligne = c->img->data + (size_t) y * c->img->rowstride;   \
+  const unsigned char* dessous = y + 1 < c->img->height ? ligne + c->img->rowstride : ligne;
+#define NOYAU_PIXEL( c, x )
+#define VOISIN_GRIS( dx, dy ) ( (dy) ? GRIS( dessous, x + (dx) ) : GRIS( ligne, x + (dx) ) )
+
+#define GRIS( l, x ) (l)[ x ]
+// Même gris
+#define NOYAU_PREDICAT( c, x, i, dx, dy ) ( GRIS( ligne, x ) == VOISIN_GRIS( dx, dy ) )
+#define NOYAU_NOM unirNiveauxDeGrisGris4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirNiveauxDeGrisGris8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_PREDICAT
+
+// Écart de gris au plus ecart
+#define NOYAU_PREDICAT( c, x, i, dx, dy ) ( abs( GRIS( ligne, x ) - VOISIN_GRIS( dx, dy ) ) <= c->ecart )
+#define NOYAU_NOM unirSimilairesGris4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirSimilairesGris8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_PREDICAT
+#undef GRIS
+
+#define GRIS( l, x ) GRIS16( l, x )
+// Même gris, sur 16 bits
+#define NOYAU_PREDICAT( c, x, i, dx, dy ) ( GRIS( ligne, x ) == VOISIN_GRIS( dx, dy ) )
+#define NOYAU_NOM unirNiveauxDeGrisGris16_4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirNiveauxDeGrisGris16_8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_PREDICAT
+
+// Écart de gris au plus ecart, sur 16 bits
+#define NOYAU_PREDICAT( c, x, i, dx, dy ) ( abs( GRIS( ligne, x ) - VOISIN_GRIS( dx, dy ) ) <= c->ecart )
+#define NOYAU_NOM unirSimilairesGris16_4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirSimilairesGris16_8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_PREDICAT
+#undef GRIS
+#undef VOISIN_GRIS
+#undef NOYAU_PIXEL
+#undef NOYAU_LIGNE
+#undef NOYAU_CONTEXTE
+
+/**
+   Étapes 2 et 3: réunit les pixels voisins de même gris.
+*/
+void unirNiveauxDeGrisGris( const ImageGrise* output, Foret* foret )
+{
+  ContexteGris c = { output, 0 };
+  bool huit = connexiteChoisie() == CONNEXITE_8;
+  if ( output->octets == 2 )
+    ( huit ? unirNiveauxDeGrisGris16_8 : unirNiveauxDeGrisGris16_4 )( &c, foret, output->width, 0, output->height );
+  else
+    ( huit ? unirNiveauxDeGrisGris8 : unirNiveauxDeGrisGris4 )( &c, foret, output->width, 0, output->height );
+}
+
+/**
+   Étapes 2 et 3 floues: réunit les voisins dont la similitude,
+   10 * | g1 - g2 | pour des gris, est au plus \a floue.
+*/
+void unirSimilairesGris( const ImageGrise* input, Foret* foret, double floue )
+{
+  if ( floue < 0 ) return;
+  // écart de gris maximal, les poids étant entiers
+  ContexteGris c = { input, floue >= 2550 ? 255 : (int) floue / 10 };
+  bool huit = connexiteChoisie() == CONNEXITE_8;
+  if ( input->octets == 2 )
+  {
+    // un écart de 1 sur l'échelle 0 .. 255 en vaut maximum / 255
+    c.ecart = floue >= 2550 ? input->maximum : (int) ( floue * input->maximum / 2550 );
+    ( huit ? unirSimilairesGris16_8 : unirSimilairesGris16_4 )( &c, foret, input->width, 0, input->height );
+  }
+  else
+    ( huit ? unirSimilairesGris8 : unirSimilairesGris4 )( &c, foret, input->width, 0, input->height );
+}
+
+/**
+   Étapes 4 à 6 de colorierGris, pour des pixels de \a octets octets:
+   étiquettes compactes et somme des gris de chaque composante. Rend
+   le nombre de composantes.
+*/
+static inline uint32_t sommerGris( const ImageGrise* input, Tampons* tampons, const int octets )
+{
+  Foret* foret = &tampons->foret;
+  uint32_t* etiquettes = tampons->etiquettes;
+  SommeCouleur* sommes = tampons->sommes;
+  TableComposantes* table = tampons->table;
+  memset( etiquettes, 0xff, foret->taille * sizeof( uint32_t ) );
+  if ( table != NULL ) commencerTable( table, input->width, input->height );
+  uint32_t nb = 0;
+  uint32_t i = 0;
+  for ( int y = 0; y < input->height; ++y )
+  {
+    const unsigned char* ligne = input->data + (size_t) y * input->rowstride;
+    for ( int x = 0; x < input->width; ++x, ++i )
+    {
+      uint32_t r = foretTrouver( foret, i );
+      if ( etiquettes[ r ] == UINT32_MAX )
+      {
+        etiquettes[ r ] = nb;
+        sommes[ nb ].rouge = 0;
+        sommes[ nb ].nb = 0;
+        if ( table != NULL ) ajouterComposante( table, x, y );
+        nb++;
+      }
+      uint32_t e = etiquettes[ i ] = etiquettes[ r ];
+      sommes[ e ].rouge += octets == 2 ? GRIS16( ligne, x ) : ligne[ x ];
+      sommes[ e ].nb += 1;
+      if ( table != NULL ) mesurerPixel( table, etiquettes, e, x, y, i );
+    }
+  }
+  return nb;
+}
+
+/**
+   Étapes 4 à 8 sur la forêt de \a tampons (voir sommerComposantes):
+   chaque pixel de \a output prend le gris moyen (tronqué) de sa
+   composante dans \a input.
+*/
+void colorierGris( const ImageGrise* input, ImageGrise* output, Tampons* tampons )
+{
+  uint32_t* etiquettes = tampons->etiquettes;
+  SommeCouleur* sommes = tampons->sommes;
+  annoncerPhase( tampons, AVANCEMENT_STATS );
+  uint32_t nb = input->octets == 2 ? sommerGris( input, tampons, 2 ) : sommerGris( input, tampons, 1 );
+  annoncerPhase( tampons, AVANCEMENT_REPEINT );
+  // la moyenne de chaque composante remplace sa somme, et va dans le
+  // rouge de sa couleur (ramenée sur 8 bits pour une image 16 bits)
+  for ( uint32_t e = 0; e < nb; ++e )
+  {
+    sommes[ e ].rouge /= sommes[ e ].nb;
+    tampons->couleurs[ e ].rouge = input->octets == 2
+      ? sommes[ e ].rouge * 255 / input->maximum : sommes[ e ].rouge;
+  }
+  uint32_t i = 0;
+  for ( int y = 0; y < output->height; ++y )
+  {
+    unsigned char* ligne = output->data + (size_t) y * output->rowstride;
+    if ( output->octets == 2 )
+      for ( int x = 0; x < output->width; ++x, ++i )
+        ecrireGris16( ligne, x, sommes[ etiquettes[ i ] ].rouge );
+    else
+      for ( int x = 0; x < output->width; ++x, ++i )
+        ligne[ x ] = tampons->couleurs[ etiquettes[ i ] ].rouge;
+  }
+  if ( tampons->table != NULL )
+  {
+    // la table veut des couleurs: le gris moyen dans les trois canaux
+    for ( uint32_t e = 0; e < nb; ++e )
+      tampons->couleurs[ e ].vert = tampons->couleurs[ e ].bleu = tampons->couleurs[ e ].rouge;
+    terminerTable( tampons->table, etiquettes, tampons->couleurs );
+  }
+  annoncerPhase( tampons, AVANCEMENT_FINI );
+}
+
+/**
+   Composantes de même gris de \a output, coloriées avec le gris moyen
+   correspondant dans \a input.
+*/
+void calculerComposantesConnexesGris( const ImageGrise* input, ImageGrise* output, Tampons* tampons )
+{
+  Foret* foret = preparerTampons( tampons, (uint32_t) output->width * output->height );
+  annoncerPhase( tampons, AVANCEMENT_UNIONS );
+  unirNiveauxDeGrisGris( output, foret );
+  colorierGris( input, output, tampons );
+}
+
+/**
+   Composantes floues de \a input, coloriées dans \a output.
+*/
+void calculerComposantesConnexesFlouesGris( const ImageGrise* input, ImageGrise* output,
+                                            double floue, Tampons* tampons )
+{
+  Foret* foret = preparerTampons( tampons, (uint32_t) input->width * input->height );
+  annoncerPhase( tampons, AVANCEMENT_UNIONS );
+  unirSimilairesGris( input, foret, floue );
+  colorierGris( input, output, tampons );
+}
@@ -0,0 +1,46 @@
+#ifndef GRIS_H
+#define GRIS_H
+
+/**
+   Segmentation des images en niveaux de gris, à un ou deux octets par
+   pixel.
+
+   Un PGM passé par gdk-pixbuf devient du RGB (g, g, g), et chaque
+   comparaison refait la moyenne de greyLevel(). Ici on travaille
+   directement sur les gris. Les résultats sont ceux des versions RGB
+   sur l'image (g, g, g): greyLevel vaut g, et similitude vaut
+   10 * | g1 - g2 | (teinte et saturation nulles).
+
+   Un PGM 16 bits (gris de 0 à maximum, poids fort en tête) est
+   segmenté sur place, à pleine précision: les composantes de même gris
+   comparent les 16 bits, et la moyenne d'une composante garde ses 16
+   bits. Le seuil et la floue restent sur l'échelle 0 .. 255 des images
+   8 bits: ils sont multipliés par maximum / 255.
+*/
+
+#include "segmentation.h"
+
+struct Tampons;
+
+/// Comme Image, avec un gris par pixel.
+typedef struct {
+  unsigned char* data;
+  int width;
+  int height;
+  int rowstride;
+  int octets;   // par pixel: 1, ou 2 (16 bits, poids fort en tête)
+  int maximum;  // blanc d'une image 16 bits (le maxval du PGM)
+} ImageGrise;
+
+void seuillerGris( const ImageGrise* input, ImageGrise* output, int seuil );
+void seuillerGrisNiveaux( const ImageGrise* input, ImageGrise* output, const int* seuils, int nb_seuils );
+void histogrammeGris( const ImageGrise* input, uint32_t* histogramme );
+void unirNiveauxDeGrisGris( const ImageGrise* output, Foret* foret );
+void unirSimilairesGris( const ImageGrise* input, Foret* foret, double floue );
+void colorierGris( const ImageGrise* input, ImageGrise* output, struct Tampons* tampons );
+void calculerComposantesConnexesGris( const ImageGrise* input, ImageGrise* output,
+                                      struct Tampons* tampons );
+void calculerComposantesConnexesFlouesGris( const ImageGrise* input, ImageGrise* output,
+                                            double floue, struct Tampons* tampons );
+
+#endif
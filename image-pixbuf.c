@@ -0,0 +1,29 @@
+#include "image-pixbuf.h"
+
+/**
+   Décrit le tampon du pixbuf sous forme d'Image (sans copie), RGB ou
+   RGBA selon le pixbuf.
+*/
+Image imageDepuisPixbuf( GdkPixbuf* pixbuf )
+{
+  Image img;
+  img.data      = gdk_pixbuf_get_pixels( pixbuf );
+  img.width     = gdk_pixbuf_get_width( pixbuf );
+  img.height    = gdk_pixbuf_get_height( pixbuf );
+  img.rowstride = gdk_pixbuf_get_rowstride( pixbuf );
+  img.canaux    = gdk_pixbuf_get_n_channels( pixbuf );
+  return img;
+}
+
+/**
+   Vrai si le pixbuf a un format traité par les algorithmes: 3 canaux
+   RGB, ou 4 avec l'alpha, à 8 bits par échantillon. (gdk-pixbuf ne
+   décode qu'en 8 bits: les images 16 bits passent par pnm.h.)
+*/
+bool pixbufCompatible( GdkPixbuf* pixbuf )
+{
+  int canaux = gdk_pixbuf_get_n_channels( pixbuf );
+  return gdk_pixbuf_get_colorspace( pixbuf ) == GDK_COLORSPACE_RGB
+    && canaux == ( gdk_pixbuf_get_has_alpha( pixbuf ) ? 4 : 3 )
+    && gdk_pixbuf_get_bits_per_sample( pixbuf ) == 8;
+}
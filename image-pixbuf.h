@@ -0,0 +1,16 @@
+#ifndef IMAGE_PIXBUF_H
+#define IMAGE_PIXBUF_H
+
+/**
+   Passerelle entre les GdkPixbuf et les Image de segmentation.h. Ne
+   dépend que de gdk-pixbuf (pas de GTK ni de serveur X), ce qui permet
+   de l'utiliser aussi en mode batch.
+*/
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include "segmentation.h"
+
+Image imageDepuisPixbuf( GdkPixbuf* pixbuf );
+bool pixbufCompatible( GdkPixbuf* pixbuf );
+
+#endif
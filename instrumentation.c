@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "instrumentation.h"
+
+#ifdef INSTRUMENTATION
+
+/// Phases chronométrées, dans l'ordre de PhaseSegmentation (tampons.h).
+#define NB_PHASES_MESUREES 4
+static const char* NOMS_PHASES[ NB_PHASES_MESUREES ] = { "empreinte", "unions", "stats", "repeint" };
+#define NB_RANGS 33
+
+_Thread_local CompteursUnionFind compteursUnionFind;
+_Thread_local uint64_t cheminCourant;
+
+/// Totaux de tous les threads et dernière analyse de forêt, sous verrou.
+static pthread_mutex_t verrou = PTHREAD_MUTEX_INITIALIZER;
+static CompteursUnionFind totaux;
+static uint64_t histogrammeRangs[ NB_RANGS ];
+static uint32_t profondeur;     // plus long chemin jusqu'à une racine
+static double profondeurMoyenne;
+static uint32_t nbComposantes;
+static uint32_t nbElements;
+static double dureeDerniere[ NB_PHASES_MESUREES ]; // ms, dernier calcul
+static double dureeTotale[ NB_PHASES_MESUREES ];   // ms, tous les calculs
+static uint64_t nbCalculs;
+static int phaseCourante = -1;
+static double debutPhase;
+
+/// Temps courant en ms (horloge monotone).
+static double horloge( void )
+{
+  struct timespec t;
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+int instrumentationActive( void )
+{
+  return 1;
+}
+
+void instrumentationRemettreAZero( void )
+{
+  pthread_mutex_lock( &verrou );
+  memset( &totaux, 0, sizeof( totaux ) );
+  memset( histogrammeRangs, 0, sizeof( histogrammeRangs ) );
+  memset( dureeDerniere, 0, sizeof( dureeDerniere ) );
+  memset( dureeTotale, 0, sizeof( dureeTotale ) );
+  profondeur = 0;
+  profondeurMoyenne = 0.0;
+  nbComposantes = 0;
+  nbElements = 0;
+  nbCalculs = 0;
+  phaseCourante = -1;
+  pthread_mutex_unlock( &verrou );
+  memset( &compteursUnionFind, 0, sizeof( compteursUnionFind ) );
+  cheminCourant = 0;
+}
+
+/**
+   Ajoute les compteurs du thread appelant aux totaux et les remet à zéro.
+*/
+void instrumentationFusionner( void )
+{
+  pthread_mutex_lock( &verrou );
+  totaux.trouver += compteursUnionFind.trouver;
+  totaux.chemin += compteursUnionFind.chemin;
+  if ( compteursUnionFind.chemin_max > totaux.chemin_max )
+    totaux.chemin_max = compteursUnionFind.chemin_max;
+  totaux.unions += compteursUnionFind.unions;
+  totaux.unions_inutiles += compteursUnionFind.unions_inutiles;
+  pthread_mutex_unlock( &verrou );
+  memset( &compteursUnionFind, 0, sizeof( compteursUnionFind ) );
+}
+
+/**
+   Début de \a phase (une PhaseSegmentation): la phase précédente se
+   termine. L'empreinte, ou les unions qui ne la suivent pas, ouvrent un
+   nouveau calcul, ce qui abandonne la phase d'un calcul interrompu; la
+   fin (AVANCEMENT_FINI) n'est pas
+   chronométrée. Si \a pere n'est pas NULL, la forêt est analysée entre
+   les deux phases, hors chronométrage.
+*/
+void instrumentationPhase( int phase, const uint32_t* pere, const uint8_t* rang, uint32_t taille )
+{
+  double t = horloge();
+  if ( pere != NULL )
+    instrumentationAnalyserForet( pere, rang, taille );
+  pthread_mutex_lock( &verrou );
+  // 0: empreinte, 1: unions
+  int ouverture = phase == 0 || ( phase == 1 && phaseCourante != 0 );
+  if ( phaseCourante >= 0 && ! ouverture )
+  {
+    dureeDerniere[ phaseCourante ] = t - debutPhase;
+    dureeTotale[ phaseCourante ] += t - debutPhase;
+  }
+  if ( ouverture )
+    memset( dureeDerniere, 0, sizeof( dureeDerniere ) );
+  if ( phase >= NB_PHASES_MESUREES )
+    nbCalculs += 1;
+  phaseCourante = phase < NB_PHASES_MESUREES ? phase : -1;
+  debutPhase = horloge();
+  pthread_mutex_unlock( &verrou );
+}
+
+/**
+   Histogramme des rangs, profondeur (maximale et moyenne) et nombre de
+   composantes de la forêt \a pere / \a rang, sans la modifier.
+*/
+void instrumentationAnalyserForet( const uint32_t* pere, const uint8_t* rang, uint32_t taille )
+{
+  uint32_t* prof = (uint32_t*) malloc( taille * sizeof( uint32_t ) );
+  memset( prof, 0xff, taille * sizeof( uint32_t ) );
+  uint64_t histogramme[ NB_RANGS ] = { 0 };
+  uint64_t somme = 0;
+  uint32_t max = 0, racines = 0;
+  for ( uint32_t i = 0; i < taille; ++i )
+  {
+    // remonte jusqu'à une racine ou un élément déjà mesuré, puis redescend
+    uint32_t j = i, k = 0;
+    while ( pere[ j ] != j && prof[ j ] == UINT32_MAX )
+    {
+      j = pere[ j ];
+      ++k;
+    }
+    uint32_t p = ( pere[ j ] == j ? 0 : prof[ j ] ) + k;
+    j = i;
+    for ( uint32_t s = 0; s < k; ++s, j = pere[ j ] )
+      prof[ j ] = p - s;
+    if ( pere[ i ] == i )
+    {
+      prof[ i ] = 0;
+      racines++;
+    }
+    somme += prof[ i ];
+    if ( prof[ i ] > max ) max = prof[ i ];
+    histogramme[ rang[ i ] < NB_RANGS ? rang[ i ] : NB_RANGS - 1 ]++;
+  }
+  free( prof );
+  pthread_mutex_lock( &verrou );
+  memcpy( histogrammeRangs, histogramme, sizeof( histogramme ) );
+  profondeur = max;
+  profondeurMoyenne = taille > 0 ? (double) somme / taille : 0.0;
+  nbComposantes = racines;
+  nbElements = taille;
+  pthread_mutex_unlock( &verrou );
+}
+
+void ecrireInstrumentationJSON( FILE* f )
+{
+  instrumentationFusionner();
+  pthread_mutex_lock( &verrou );
+  fprintf( f, "{\n  \"instrumentation\": true,\n" );
+  fprintf( f, "  \"trouver\": %llu,\n  \"chemin_total\": %llu,\n  \"chemin_max\": %llu,\n",
+           (unsigned long long) totaux.trouver, (unsigned long long) totaux.chemin,
+           (unsigned long long) totaux.chemin_max );
+  fprintf( f, "  \"chemin_moyen\": %.4f,\n",
+           totaux.trouver > 0 ? (double) totaux.chemin / totaux.trouver : 0.0 );
+  fprintf( f, "  \"unions\": %llu,\n  \"unions_inutiles\": %llu,\n",
+           (unsigned long long) totaux.unions, (unsigned long long) totaux.unions_inutiles );
+  fprintf( f, "  \"foret\": { \"elements\": %u, \"composantes\": %u, \"profondeur\": %u,"
+           " \"profondeur_moyenne\": %.4f, \"rangs\": [",
+           nbElements, nbComposantes, profondeur, profondeurMoyenne );
+  int dernier = 0;
+  for ( int r = 0; r < NB_RANGS; ++r )
+    if ( histogrammeRangs[ r ] != 0 ) dernier = r;
+  for ( int r = 0; r <= dernier; ++r )
+    fprintf( f, "%s%llu", r > 0 ? ", " : " ", (unsigned long long) histogrammeRangs[ r ] );
+  fprintf( f, " ] },\n  \"calculs\": %llu,\n  \"phases_ms\": {", (unsigned long long) nbCalculs );
+  for ( int p = 0; p < NB_PHASES_MESUREES; ++p )
+    fprintf( f, "%s \"%s\": { \"dernier\": %.4f, \"total\": %.4f }", p > 0 ? "," : "",
+             NOMS_PHASES[ p ], dureeDerniere[ p ], dureeTotale[ p ] );
+  fprintf( f, " }\n}\n" );
+  pthread_mutex_unlock( &verrou );
+}
+
+#else
+
+int instrumentationActive( void ) { return 0; }
+void instrumentationRemettreAZero( void ) {}
+void instrumentationFusionner( void ) {}
+void instrumentationPhase( int phase, const uint32_t* pere, const uint8_t* rang, uint32_t taille ) {}
+void instrumentationAnalyserForet( const uint32_t* pere, const uint8_t* rang, uint32_t taille ) {}
+
+void ecrireInstrumentationJSON( FILE* f )
+{
+  fprintf( f, "{\n  \"instrumentation\": false\n}\n" );
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+/**
+   Instrumentation de l'union-find: nombre de recherches, longueur
+   totale et maximale des chemins remontés, unions effectives et
+   inutiles, puis, à la fin des unions, histogramme des rangs,
+   profondeur de la forêt et nombre de composantes. Les phases annoncées
+   par annoncerPhase (tampons.h) sont chronométrées avec une horloge
+   monotone.
+
+   Tout n'est compilé qu'avec -DINSTRUMENTATION (variable INSTRUMENTATION
+   du Makefile). Sinon INSTRUMENTER( ... ) ne produit rien: le code
+   mesuré est exactement le code normal, et les fonctions ci-dessous ne
+   font rien (instrumentationActive() rend FALSE).
+
+   Les compteurs sont propres à chaque thread; instrumentationFusionner
+   les ajoute aux totaux, que ecrireInstrumentationJSON écrit.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#ifdef INSTRUMENTATION
+
+#define INSTRUMENTER( ... ) __VA_ARGS__
+
+/// Compteurs d'un thread, ajoutés aux totaux par instrumentationFusionner.
+typedef struct {
+  uint64_t trouver;         // recherches de représentant
+  uint64_t chemin;          // pères suivis, toutes recherches confondues
+  uint64_t chemin_max;      // plus long chemin d'une recherche
+  uint64_t unions;          // unions qui ont réuni deux ensembles
+  uint64_t unions_inutiles; // unions de deux éléments déjà ensemble
+} CompteursUnionFind;
+
+extern _Thread_local CompteursUnionFind compteursUnionFind;
+extern _Thread_local uint64_t cheminCourant;
+
+/// Un père de plus suivi par la recherche en cours.
+static inline void compterPas( void )
+{
+  ++cheminCourant;
+}
+
+/// Fin d'une recherche: son chemin est celui compté depuis la précédente.
+static inline void compterTrouver( void )
+{
+  compteursUnionFind.trouver += 1;
+  compteursUnionFind.chemin += cheminCourant;
+  if ( cheminCourant > compteursUnionFind.chemin_max )
+    compteursUnionFind.chemin_max = cheminCourant;
+  cheminCourant = 0;
+}
+
+static inline void compterUnion( int utile )
+{
+  if ( utile ) compteursUnionFind.unions += 1;
+  else         compteursUnionFind.unions_inutiles += 1;
+}
+
+#else
+
+#define INSTRUMENTER( ... )
+
+#endif
+
+int instrumentationActive( void );
+void instrumentationRemettreAZero( void );
+void instrumentationFusionner( void );
+void instrumentationPhase( int phase, const uint32_t* pere, const uint8_t* rang, uint32_t taille );
+void instrumentationAnalyserForet( const uint32_t* pere, const uint8_t* rang, uint32_t taille );
+void ecrireInstrumentationJSON( FILE* f );
+
+#endif
@@ -0,0 +1,99 @@
+/**
+   Noyau d'unions des composantes connexes, spécialisé à la compilation
+   sur le voisinage et sur le prédicat de fusion.
+
+   Ce fichier n'a pas de garde: on l'inclut une fois par noyau, après
+   avoir défini
+
+   NOYAU_NOM                          nom de la fonction générée
+   NOYAU_VOISINAGE( V )               voisins, par exemple VOISINAGE_4 ou VOISINAGE_8
+   NOYAU_CONTEXTE                     type des données lues par le prédicat
+   NOYAU_LIGNE( c, y )                déclarations faites au début de chaque ligne
+   NOYAU_PIXEL( c, x )                déclarations faites pour chaque pixel
+   NOYAU_PREDICAT( c, x, i, dx, dy )  vrai si le pixel ( x, y ), d'indice i,
+                                      est à réunir à ( x + dx, y + dy )
+
+   (NOYAU_LIGNE et NOYAU_PIXEL peuvent être vides; le prédicat peut
+   aussi lire y et width). NOYAU_UNION, facultative, est la fonction
+   d'union ( foret, i, j ): foretUnion par défaut. La fonction générée
+
+     static void NOYAU_NOM( const NOYAU_CONTEXTE* c, Foret* foret, int width, int y0, int y1 )
+
+   réunit les voisins des lignes [ y0, y1 [ sans sortir de la bande,
+   comme unirNiveauxDeGrisBande. La première et la dernière colonne et
+   la dernière ligne de la bande sont traitées à part: la boucle des
+   pixels intérieurs n'a ni test de bord ni modulo, et le voisinage y
+   est déroulé par le préprocesseur.
+
+   NOYAU_NOM et NOYAU_VOISINAGE sont indéfinis à la fin: on peut
+   réinclure le fichier pour générer un autre voisinage avec le même
+   prédicat. Les autres macros sont à indéfinir par l'appelant.
+*/
+
+#include "foret.h"
+
+#ifndef VOISINAGE_4
+/**
+   Un voisinage est la liste des voisins V( dx, dy ) "en avant" d'un
+   pixel (dy == 1, ou dy == 0 et dx == 1): chaque paire de voisins n'est
+   ainsi vue qu'une fois. Les voisins restent dans le carré 3x3 autour du
+   pixel. Pour un voisinage à la carte, par exemple les seules diagonales:
+   #define VOISINAGE_DIAGONALES( V ) V( -1, 1 ) V( 1, 1 )
+*/
+#define VOISINAGE_4( V ) V( 1, 0 ) V( 0, 1 )
+#define VOISINAGE_8( V ) V( 1, 0 ) V( -1, 1 ) V( 0, 1 ) V( 1, 1 )
+#endif
+
+#ifdef NOYAU_UNION
+#define NOYAU_UNION_CHOISIE NOYAU_UNION
+#else
+#define NOYAU_UNION_CHOISIE foretUnion
+#endif
+
+/// Voisin d'un pixel intérieur: aucun test.
+#define NOYAU_UNIR( dx, dy )                                \
+  if ( NOYAU_PREDICAT( c, x, i, dx, dy ) )                  \
+    NOYAU_UNION_CHOISIE( foret, i, i + (dy) * width + (dx) );
+
+/// Voisin d'un pixel du bord: il doit être dans la bande.
+#define NOYAU_UNIR_BORD( dx, dy )                                   \
+  if ( ( (dx) >= 0 || x > 0 ) && ( (dx) <= 0 || x + 1 < width )     \
+       && ( (dy) == 0 || bas ) )                                    \
+    NOYAU_UNIR( dx, dy )
+
+static void NOYAU_NOM( const NOYAU_CONTEXTE* c, Foret* foret, int width, int y0, int y1 )
+{
+  for ( int y = y0; y < y1; ++y )
+  {
+    NOYAU_LIGNE( c, y )
+    bool bas = y + 1 < y1;
+    uint32_t i = (uint32_t) y * width;
+    int x = 0;
+    if ( bas && width > 2 )
+    {
+      // première colonne
+      {
+        NOYAU_PIXEL( c, x )
+        NOYAU_VOISINAGE( NOYAU_UNIR_BORD )
+      }
+      // pixels intérieurs
+      for ( ++x, ++i; x + 1 < width; ++x, ++i )
+      {
+        NOYAU_PIXEL( c, x )
+        NOYAU_VOISINAGE( NOYAU_UNIR )
+      }
+    }
+    // dernière colonne, ou toute la ligne si c'est la dernière de la bande
+    for ( ; x < width; ++x, ++i )
+    {
+      NOYAU_PIXEL( c, x )
+      NOYAU_VOISINAGE( NOYAU_UNIR_BORD )
+    }
+  }
+}
+
+#undef NOYAU_UNIR_BORD
+#undef NOYAU_UNIR
+#undef NOYAU_UNION_CHOISIE
+#undef NOYAU_VOISINAGE
+#undef NOYAU_NOM
@@ -0,0 +1,172 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include "parallele.h"
+
+/// Travail confié à un thread: une bande [ y0, y1 [ de l'image.
+typedef struct {
+  const Image* input;
+  const Image* output;
+  Foret* foret;
+  const PlansTSV* plans;  // si non nul: poids <= floue plutôt qu'égalité des gris
+  double floue;
+  Tampons* tampons;       // étiquettes et couleurs des composantes
+  int y0;
+  int y1;
+} Bande;
+
+typedef void* (*FonctionBande)( void* );
+
+/**
+   Découpe l'image en \a nb_threads bandes et lance \a travail sur
+   chacune, puis attend la fin de tous les threads.
+*/
+static void lancerBandes( Bande* modele, int height, int nb_threads, FonctionBande travail )
+{
+  if ( nb_threads > height ) nb_threads = height;
+  if ( nb_threads < 1 ) nb_threads = 1;
+  Bande* bandes = (Bande*) malloc( nb_threads * sizeof( Bande ) );
+  pthread_t* threads = (pthread_t*) malloc( nb_threads * sizeof( pthread_t ) );
+  for ( int k = 0; k < nb_threads; ++k )
+  {
+    bandes[ k ] = *modele;
+    bandes[ k ].y0 = (int) ( (long) height * k / nb_threads );
+    bandes[ k ].y1 = (int) ( (long) height * ( k + 1 ) / nb_threads );
+  }
+  // le thread appelant traite la dernière bande
+  for ( int k = 0; k < nb_threads - 1; ++k )
+    pthread_create( &threads[ k ], NULL, travail, &bandes[ k ] );
+  travail( &bandes[ nb_threads - 1 ] );
+  for ( int k = 0; k < nb_threads - 1; ++k )
+    pthread_join( threads[ k ], NULL );
+  free( threads );
+  free( bandes );
+}
+
+static void* unirBande( void* arg )
+{
+  Bande* b = (Bande*) arg;
+  if ( b->plans != NULL )
+    unirPoidsBande( b->plans, b->foret, b->floue, b->y0, b->y1 );
+  else
+    unirNiveauxDeGrisBande( b->output, b->foret, b->y0, b->y1 );
+  INSTRUMENTER( instrumentationFusionner(); )
+  return NULL;
+}
+
+/**
+   Unions par bandes, puis réunion séquentielle le long des frontières.
+*/
+static void unirParallele( const Image* output, const PlansTSV* plans, Foret* foret,
+                           double floue, int nb_threads )
+{
+  Bande modele = { NULL, output, foret, plans, floue, NULL, 0, 0 };
+  if ( nb_threads > output->height ) nb_threads = output->height;
+  lancerBandes( &modele, output->height, nb_threads, unirBande );
+
+  // Frontières: la dernière ligne de chaque bande (sauf la dernière)
+  // avec la première de la suivante, dans le voisinage choisi. Les
+  // unions horizontales de ces deux lignes sont refaites, sans effet.
+  for ( int k = 1; k < nb_threads; ++k )
+  {
+    int y = (int) ( (long) output->height * k / nb_threads );
+    if ( plans != NULL )
+      unirPoidsBande( plans, foret, floue, y - 1, y + 1 );
+    else
+      unirNiveauxDeGrisBande( output, foret, y - 1, y + 1 );
+  }
+}
+
+void unirNiveauxDeGrisParallele( const Image* output, Foret* foret, int nb_threads )
+{
+  unirParallele( output, NULL, foret, 0.0, nb_threads );
+}
+
+void unirSimilairesParallele( const Image* output, const PlansTSV* plans, Foret* foret,
+                              double floue, int nb_threads )
+{
+  unirParallele( output, plans, foret, floue, nb_threads );
+}
+
+/**
+   Unions de la bande et de sa frontière avec la suivante (la première
+   ligne de celle-ci), sur la forêt partagée.
+*/
+static void* unirBandeConcurrente( void* arg )
+{
+  Bande* b = (Bande*) arg;
+  int height = b->plans != NULL ? b->plans->height : b->output->height;
+  int y1 = b->y1 < height ? b->y1 + 1 : b->y1;
+  if ( b->plans != NULL )
+    unirPoidsBandeConcurrente( b->plans, b->foret, b->floue, b->y0, y1 );
+  else
+    unirNiveauxDeGrisBandeConcurrente( b->output, b->foret, b->y0, y1 );
+  INSTRUMENTER( instrumentationFusionner(); )
+  return NULL;
+}
+
+/**
+   Unions sans verrou de tous les threads sur \a foret: chaque thread
+   prend une bande, frontière comprise. Aucune phase séquentielle.
+*/
+void unirNiveauxDeGrisConcurrents( const Image* output, Foret* foret, int nb_threads )
+{
+  Bande modele = { NULL, output, foret, NULL, 0.0, NULL, 0, 0 };
+  lancerBandes( &modele, output->height, nb_threads, unirBandeConcurrente );
+}
+
+void unirSimilairesConcurrents( const PlansTSV* plans, Foret* foret, double floue, int nb_threads )
+{
+  Bande modele = { NULL, NULL, foret, plans, floue, NULL, 0, 0 };
+  lancerBandes( &modele, plans->height, nb_threads, unirBandeConcurrente );
+}
+
+/**
+   Étiquette chaque pixel de la bande par sa racine. La forêt n'est
+   plus modifiée: on remonte sans compresser, en lecture seule.
+*/
+static void* etiqueterBande( void* arg )
+{
+  Bande* b = (Bande*) arg;
+  const uint32_t* pere = b->foret->pere;
+  uint32_t* etiquettes = b->tampons->etiquettes;
+  uint32_t fin = (uint32_t) b->y1 * b->output->width;
+  for ( uint32_t i = (uint32_t) b->y0 * b->output->width; i < fin; ++i )
+  {
+    uint32_t r = i;
+    while ( pere[ r ] != r )
+      r = pere[ r ];
+    etiquettes[ i ] = r;
+  }
+  return NULL;
+}
+
+static void* peindreBande( void* arg )
+{
+  Bande* b = (Bande*) arg;
+  peindreComposantes( (Image*) b->output, b->tampons, b->y0, b->y1 );
+  return NULL;
+}
+
+/**
+   Étapes 4 à 6: étiquette chaque pixel par sa racine (en parallèle),
+   puis compacte les étiquettes et somme les couleurs de \a input.
+   L'accumulation reste séquentielle mais ne fait plus que lire les
+   étiquettes. Rend le nombre de composantes.
+*/
+uint32_t sommerComposantesParallele( const Image* input, Tampons* tampons, int nb_threads )
+{
+  Bande modele = { input, input, &tampons->foret, NULL, 0.0, tampons, 0, 0 };
+  lancerBandes( &modele, input->height, nb_threads, etiqueterBande );
+  return sommerEtiquettes( input, tampons );
+}
+
+/**
+   Étapes 7 et 8: moyenne des \a nb composantes, puis chaque pixel prend
+   (en parallèle) la couleur de son étiquette.
+*/
+void peindreComposantesParallele( Image* output, Tampons* tampons, uint32_t nb, int nb_threads )
+{
+  moyennerComposantes( tampons, nb );
+  Bande modele = { NULL, output, NULL, NULL, 0.0, tampons, 0, 0 };
+  lancerBandes( &modele, output->height, nb_threads, peindreBande );
+}
@@ -0,0 +1,31 @@
+#ifndef PARALLELE_H
+#define PARALLELE_H
+
+/**
+   Composantes connexes multi-threads par bandes horizontales.
+
+   L'image est découpée en autant de bandes que de threads. Chaque
+   thread fait les unions internes à sa bande (elles ne touchent que
+   les pixels de la bande, donc pas de conflit), puis on réunit en
+   séquentiel les composantes le long des frontières entre bandes.
+   L'étiquetage final et le recoloriage sont de nouveau faits en
+   parallèle. Le résultat est identique au calcul séquentiel.
+
+   Les variantes Concurrents se passent de la réunion séquentielle:
+   tous les threads font leurs unions sur la même forêt, sans verrou
+   (foret-concurrente.h), y compris celles qui traversent une frontière.
+*/
+
+#include "segmentation.h"
+#include "plans-tsv.h"
+#include "tampons.h"
+
+void unirNiveauxDeGrisParallele( const Image* output, Foret* foret, int nb_threads );
+void unirSimilairesParallele( const Image* output, const PlansTSV* plans, Foret* foret,
+                              double floue, int nb_threads );
+void unirNiveauxDeGrisConcurrents( const Image* output, Foret* foret, int nb_threads );
+void unirSimilairesConcurrents( const PlansTSV* plans, Foret* foret, double floue, int nb_threads );
+uint32_t sommerComposantesParallele( const Image* input, Tampons* tampons, int nb_threads );
+void peindreComposantesParallele( Image* output, Tampons* tampons, uint32_t nb, int nb_threads );
+
+#endif
@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include "plages.h"
+
+/**
+   Découpe chaque ligne de \a img en plages de même niveau de gris.
+*/
+Plages* encoderPlages( const Image* img )
+{
+  Plages* p = (Plages*) malloc( sizeof( Plages ) );
+  uint32_t capacite = 2 * (uint32_t) img->height + 16;
+  p->plages = (Plage*) malloc( capacite * sizeof( Plage ) );
+  p->ligne  = (uint32_t*) malloc( ( img->height + 1 ) * sizeof( uint32_t ) );
+  p->height = img->height;
+  p->nb = 0;
+  for ( int y = 0; y < img->height; ++y )
+  {
+    Pixel* ligne = pixelImage( img, 0, y );
+    p->ligne[ y ] = p->nb;
+    int x0 = 0;
+    while ( x0 < img->width )
+    {
+      unsigned char g = greyLevel( PIXEL_LIGNE( ligne, x0, img->canaux ) );
+      int x1 = x0 + 1;
+      while ( x1 < img->width && greyLevel( PIXEL_LIGNE( ligne, x1, img->canaux ) ) == g )
+        ++x1;
+      if ( p->nb == capacite )
+      {
+        capacite *= 2;
+        p->plages = (Plage*) realloc( p->plages, capacite * sizeof( Plage ) );
+      }
+      p->plages[ p->nb ].x0 = x0;
+      p->plages[ p->nb ].x1 = x1;
+      p->plages[ p->nb ].gris = g;
+      ++p->nb;
+      x0 = x1;
+    }
+  }
+  p->ligne[ img->height ] = p->nb;
+  p->foret = creerForet( p->nb );
+  return p;
+}
+
+/**
+   Réunit chaque plage avec les plages de même gris de la ligne
+   précédente qui la touchent: qui la chevauchent en 4-connexité, ou
+   qui s'arrêtent juste avant ou juste après elle en 8-connexité. Les
+   deux listes sont triées par x, on les parcourt ensemble.
+*/
+void unirPlages( Plages* p )
+{
+  int marge = connexiteChoisie() == CONNEXITE_8 ? 1 : 0;
+  for ( int y = 1; y < p->height; ++y )
+  {
+    uint32_t a = p->ligne[ y - 1 ], fin_a = p->ligne[ y ];
+    uint32_t b = p->ligne[ y ],     fin_b = p->ligne[ y + 1 ];
+    while ( a < fin_a && b < fin_b )
+    {
+      Plage* pa = &p->plages[ a ];
+      Plage* pb = &p->plages[ b ];
+      if ( pa->gris == pb->gris && pa->x0 < pb->x1 + marge && pb->x0 < pa->x1 + marge )
+        foretUnion( p->foret, a, b );
+      // avance celle qui finit en premier
+      if ( pa->x1 < pb->x1 ) ++a;
+      else if ( pb->x1 < pa->x1 ) ++b;
+      else
+      { // en 8-connexité, chacune touche encore en diagonale la suivante de l'autre
+        if ( marge && a + 1 < fin_a && pa[ 1 ].gris == pb->gris )
+          foretUnion( p->foret, a + 1, b );
+        if ( marge && b + 1 < fin_b && pb[ 1 ].gris == pa->gris )
+          foretUnion( p->foret, a, b + 1 );
+        ++a; ++b;
+      }
+    }
+  }
+}
+
+/**
+   Somme les couleurs de \a input sur chaque plage racine. Le tableau
+   retourné (indexé par plage) est à libérer avec free.
+*/
+StatCouleur* calculerStatsPlages( const Image* input, Plages* p )
+{
+  StatCouleur* stats = (StatCouleur*) calloc( p->nb, sizeof( StatCouleur ) );
+  for ( int y = 0; y < p->height; ++y )
+  {
+    Pixel* ligne = pixelImage( input, 0, y );
+    for ( uint32_t k = p->ligne[ y ]; k < p->ligne[ y + 1 ]; ++k )
+    {
+      StatCouleur* s = &stats[ foretTrouver( p->foret, k ) ];
+      for ( int x = p->plages[ k ].x0; x < p->plages[ k ].x1; ++x )
+      {
+        const Pixel* pixel = PIXEL_LIGNE( ligne, x, input->canaux );
+        s->rouge += pixel->rouge;
+        s->vert  += pixel->vert;
+        s->bleu  += pixel->bleu;
+      }
+      s->nb += p->plages[ k ].x1 - p->plages[ k ].x0;
+    }
+  }
+  return stats;
+}
+
+/**
+   Remplit chaque plage avec la couleur moyenne de sa composante.
+*/
+void repeindrePlages( Image* output, Plages* p, StatCouleur* stats )
+{
+  for ( int y = 0; y < p->height; ++y )
+  {
+    Pixel* ligne = pixelImage( output, 0, y );
+    for ( uint32_t k = p->ligne[ y ]; k < p->ligne[ y + 1 ]; ++k )
+    {
+      StatCouleur* s = &stats[ foretTrouver( p->foret, k ) ];
+      Pixel couleur;
+      couleur.rouge = s->rouge / s->nb;
+      couleur.vert  = s->vert  / s->nb;
+      couleur.bleu  = s->bleu  / s->nb;
+      for ( int x = p->plages[ k ].x0; x < p->plages[ k ].x1; ++x )
+        *PIXEL_LIGNE( ligne, x, output->canaux ) = couleur;
+    }
+  }
+}
+
+void libererPlages( Plages* p )
+{
+  if ( p == NULL ) return;
+  libererForet( p->foret );
+  free( p->plages );
+  free( p->ligne );
+  free( p );
+}
+
+/**
+   Même calcul que calculerComposantesConnexes, par plages.
+*/
+void composantesParPlages( const Image* input, Image* output )
+{
+  Plages* p = encoderPlages( output );
+  unirPlages( p );
+  StatCouleur* stats = calculerStatsPlages( input, p );
+  repeindrePlages( output, p, stats );
+  free( stats );
+  libererPlages( p );
+}
@@ -0,0 +1,39 @@
+#ifndef PLAGES_H
+#define PLAGES_H
+
+/**
+   Composantes connexes par plages (run-length): chaque ligne est
+   codée en plages de pixels consécutifs de même niveau de gris, et on
+   réunit chaque plage avec les plages de même gris de la ligne
+   précédente qui la chevauchent. Sur une image seuillée il y a
+   quelques plages par ligne au lieu de width pixels, donc beaucoup
+   moins d'unions. Les composantes obtenues sont les mêmes qu'avec
+   unirNiveauxDeGrisForet, dans le voisinage choisi (choisirConnexite).
+*/
+
+#include "segmentation.h"
+
+/// Une plage de pixels [ x0, x1 [ de même niveau de gris sur une ligne.
+typedef struct {
+  int x0;
+  int x1;
+  unsigned char gris;
+} Plage;
+
+/// Les plages de toute l'image; celles de la ligne y sont les indices [ ligne[ y ], ligne[ y + 1 ] [.
+typedef struct {
+  Plage* plages;
+  uint32_t* ligne;
+  uint32_t nb;
+  int height;
+  Foret* foret; // une entrée par plage
+} Plages;
+
+Plages* encoderPlages( const Image* img );
+void unirPlages( Plages* plages );
+StatCouleur* calculerStatsPlages( const Image* input, Plages* plages );
+void repeindrePlages( Image* output, Plages* plages, StatCouleur* stats );
+void libererPlages( Plages* plages );
+void composantesParPlages( const Image* input, Image* output );
+
+#endif
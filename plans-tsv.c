@@ -0,0 +1,264 @@
+#include <stdlib.h>
+#include <string.h>
+#include "plans-tsv.h"
+#include "foret-concurrente.h"
+#if defined( __AVX2__ ) || defined( __SSE4_1__ )
+#include <immintrin.h>
+#endif
+
+/// Remplit les plans t/s/v de \a p, pour des pixels de \a canaux octets.
+static inline void convertirPixels( const Image* img, PlansTSV* p, const int canaux )
+{
+  size_t i = 0;
+  for ( int y = 0; y < img->height; ++y )
+  {
+    Pixel* ligne = pixelImage( img, 0, y );
+    for ( int x = 0; x < img->width; ++x, ++i )
+    {
+      TSVCouleur c = tsv( PIXEL_LIGNE( ligne, x, canaux ) );
+      p->t[ i ] = c.t;
+      p->s[ i ] = c.s;
+      p->v[ i ] = c.v;
+    }
+  }
+}
+
+/**
+   Convertit \a img (RGB ou RGBA) en plans t/s/v et calcule les poids de
+   toutes les arêtes.
+*/
+PlansTSV* creerPlansTSV( const Image* img )
+{
+  size_t size = (size_t) img->width * img->height;
+  PlansTSV* p = (PlansTSV*) malloc( sizeof( PlansTSV ) );
+  p->width  = img->width;
+  p->height = img->height;
+  p->t = (int16_t*) malloc( size * sizeof( int16_t ) );
+  p->s = (uint8_t*) malloc( size );
+  p->v = (uint8_t*) malloc( size );
+  p->horizontal = (uint16_t*) calloc( size, sizeof( uint16_t ) );
+  p->vertical   = (uint16_t*) malloc( size * sizeof( uint16_t ) );
+
+  SELON_CANAUX( img, convertirPixels( img, p, canaux ) );
+
+  // arêtes horizontales, ligne par ligne
+  for ( int y = 0; y < img->height; ++y )
+  {
+    size_t d = (size_t) y * img->width;
+    poidsAretes( p->t + d, p->t + d + 1, p->s + d, p->s + d + 1, p->v + d, p->v + d + 1,
+                 p->horizontal + d, img->width - 1 );
+  }
+  // arêtes verticales: le plan et le plan décalé d'une ligne
+  if ( img->height > 1 )
+    poidsAretes( p->t, p->t + img->width, p->s, p->s + img->width, p->v, p->v + img->width,
+                 p->vertical, ( img->height - 1 ) * img->width );
+  return p;
+}
+
+/// L'arête de direction \a d part-elle du pixel ( \a x, \a y )?
+static inline bool areteExiste( const PlansTSV* plans, int x, int y, int d )
+{
+  return ( d == 0 || y + 1 < plans->height )
+    && x + dxArete( d ) >= 0 && x + dxArete( d ) < plans->width;
+}
+
+/**
+   Toutes les arêtes entre voisins de \a plans, triées par poids
+   croissant (tri par dénombrement: les poids sont bornés par
+   POIDS_MAX), à égalité dans l'ordre des pixels. L'arête 4i + d part
+   du pixel i dans la direction d (images d'au plus 2^30 pixels). Le
+   tableau rendu est à libérer avec free; \a nb_aretes reçoit sa taille.
+   Si \a debuts n'est pas NULL (POIDS_MAX + 2 cases), les arêtes de
+   poids w y sont les cases debuts[ w ] .. debuts[ w + 1 ] - 1.
+*/
+uint32_t* trierAretesTSV( const PlansTSV* plans, Connexite connexite, uint32_t* nb_aretes,
+                          uint32_t* debuts )
+{
+  int width = plans->width;
+  int height = plans->height;
+  int nb_directions = connexite == CONNEXITE_8 ? 4 : 2;
+  uint32_t* compte = (uint32_t*) calloc( POIDS_MAX + 2, sizeof( uint32_t ) );
+  uint32_t nb = 0;
+  uint32_t i = 0;
+  for ( int y = 0; y < height; ++y )
+    for ( int x = 0; x < width; ++x, ++i )
+      for ( int d = 0; d < nb_directions; ++d )
+        if ( areteExiste( plans, x, y, d ) )
+        {
+          compte[ poidsArete( plans, i, d ) + 1 ]++;
+          nb++;
+        }
+  for ( int w = 1; w <= POIDS_MAX + 1; ++w )
+    compte[ w ] += compte[ w - 1 ];
+  if ( debuts != NULL )
+    memcpy( debuts, compte, ( POIDS_MAX + 2 ) * sizeof( uint32_t ) );
+  uint32_t* aretes = (uint32_t*) malloc( ( nb + 1 ) * sizeof( uint32_t ) );
+  i = 0;
+  for ( int y = 0; y < height; ++y )
+    for ( int x = 0; x < width; ++x, ++i )
+      for ( int d = 0; d < nb_directions; ++d )
+        if ( areteExiste( plans, x, y, d ) )
+          aretes[ compte[ poidsArete( plans, i, d ) ]++ ] = 4 * i + d;
+  free( compte );
+  *nb_aretes = nb;
+  return aretes;
+}
+
+void libererPlansTSV( PlansTSV* p )
+{
+  if ( p == NULL ) return;
+  free( p->t );
+  free( p->s );
+  free( p->v );
+  free( p->horizontal );
+  free( p->vertical );
+  free( p );
+}
+
+/**
+   Nom du jeu d'instructions utilisé par poidsAretes.
+*/
+const char* jeuInstructionsPoids( void )
+{
+#if defined( __AVX2__ )
+  return "avx2";
+#elif defined( __SSE4_1__ )
+  return "sse4.1";
+#else
+  return "scalaire";
+#endif
+}
+
+#if defined( __AVX2__ )
+static inline __m256i poidsAVX2( __m256i t1, __m256i t2, __m256i s1, __m256i s2, __m256i v1, __m256i v2 )
+{
+  const __m256i c360 = _mm256_set1_epi16( 360 );
+  __m256i dt = _mm256_sub_epi16( t1, t2 );
+  dt = _mm256_sub_epi16( dt, _mm256_and_si256( _mm256_cmpgt_epi16( dt, _mm256_set1_epi16( 179 ) ), c360 ) );
+  dt = _mm256_add_epi16( dt, _mm256_and_si256( _mm256_cmpgt_epi16( _mm256_set1_epi16( -179 ), dt ), c360 ) );
+  __m256i ds = _mm256_abs_epi16( _mm256_sub_epi16( s1, s2 ) );
+  __m256i dv = _mm256_abs_epi16( _mm256_sub_epi16( v1, v2 ) );
+  return _mm256_add_epi16( _mm256_abs_epi16( dt ),
+                           _mm256_add_epi16( _mm256_mullo_epi16( ds, _mm256_set1_epi16( 5 ) ),
+                                             _mm256_mullo_epi16( dv, _mm256_set1_epi16( 10 ) ) ) );
+}
+#elif defined( __SSE4_1__ )
+static inline __m128i poidsSSE( __m128i t1, __m128i t2, __m128i s1, __m128i s2, __m128i v1, __m128i v2 )
+{
+  const __m128i c360 = _mm_set1_epi16( 360 );
+  __m128i dt = _mm_sub_epi16( t1, t2 );
+  dt = _mm_sub_epi16( dt, _mm_and_si128( _mm_cmpgt_epi16( dt, _mm_set1_epi16( 179 ) ), c360 ) );
+  dt = _mm_add_epi16( dt, _mm_and_si128( _mm_cmplt_epi16( dt, _mm_set1_epi16( -179 ) ), c360 ) );
+  __m128i ds = _mm_abs_epi16( _mm_sub_epi16( s1, s2 ) );
+  __m128i dv = _mm_abs_epi16( _mm_sub_epi16( v1, v2 ) );
+  return _mm_add_epi16( _mm_abs_epi16( dt ),
+                        _mm_add_epi16( _mm_mullo_epi16( ds, _mm_set1_epi16( 5 ) ),
+                                       _mm_mullo_epi16( dv, _mm_set1_epi16( 10 ) ) ) );
+}
+#endif
+
+/**
+   poids[ k ] = poids de l'arête entre les pixels k des plans 1 et 2,
+   pour k dans [ 0, n [.
+*/
+void poidsAretes( const int16_t* t1, const int16_t* t2, const uint8_t* s1, const uint8_t* s2,
+                  const uint8_t* v1, const uint8_t* v2, uint16_t* poids, int n )
+{
+  int k = 0;
+#if defined( __AVX2__ )
+  for ( ; k + 16 <= n; k += 16 )
+  {
+    __m256i w = poidsAVX2( _mm256_loadu_si256( (const __m256i*) ( t1 + k ) ),
+                           _mm256_loadu_si256( (const __m256i*) ( t2 + k ) ),
+                           _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*) ( s1 + k ) ) ),
+                           _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*) ( s2 + k ) ) ),
+                           _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*) ( v1 + k ) ) ),
+                           _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*) ( v2 + k ) ) ) );
+    _mm256_storeu_si256( (__m256i*) ( poids + k ), w );
+  }
+#elif defined( __SSE4_1__ )
+  for ( ; k + 8 <= n; k += 8 )
+  {
+    __m128i w = poidsSSE( _mm_loadu_si128( (const __m128i*) ( t1 + k ) ),
+                          _mm_loadu_si128( (const __m128i*) ( t2 + k ) ),
+                          _mm_cvtepu8_epi16( _mm_loadl_epi64( (const __m128i*) ( s1 + k ) ) ),
+                          _mm_cvtepu8_epi16( _mm_loadl_epi64( (const __m128i*) ( s2 + k ) ) ),
+                          _mm_cvtepu8_epi16( _mm_loadl_epi64( (const __m128i*) ( v1 + k ) ) ),
+                          _mm_cvtepu8_epi16( _mm_loadl_epi64( (const __m128i*) ( v2 + k ) ) ) );
+    _mm_storeu_si128( (__m128i*) ( poids + k ), w );
+  }
+#endif
+  for ( ; k < n; ++k )
+    poids[ k ] = poidsScalaire( t1[ k ], t2[ k ], s1[ k ], s2[ k ], v1[ k ], v2[ k ] );
+}
+
+/// Données des noyaux d'unions sur les poids (voir noyau-unions.h).
+typedef struct {
+  const PlansTSV* plans;
+  uint32_t seuil;
+} ContextePoids;
+
+// Les arêtes horizontales et verticales sont précalculées, les diagonales
+// (8-connexité) sont pesées à la volée.
+#define NOYAU_CONTEXTE ContextePoids
+#define NOYAU_LIGNE( c, y )                                             \
+  const uint16_t* h = c->plans->horizontal + (size_t) y * width;        \
+  const uint16_t* v = c->plans->vertical + (size_t) y * width;
+#define NOYAU_PIXEL( c, x )
+#define NOYAU_PREDICAT( c, x, i, dx, dy )                                   \
+  ( ( (dy) == 0 ? h[ x ] : (dx) == 0 ? v[ x ]                               \
+      : poidsTSV( c->plans, i, i + width + (dx) ) ) <= c->seuil )
+#define NOYAU_NOM unirPoids4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirPoids8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+// Mêmes noyaux sur une forêt partagée entre threads
+#define NOYAU_UNION foretUnionConcurrente
+#define NOYAU_NOM unirPoidsConcurrents4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirPoidsConcurrents8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_UNION
+#undef NOYAU_PREDICAT
+#undef NOYAU_PIXEL
+#undef NOYAU_LIGNE
+#undef NOYAU_CONTEXTE
+
+/**
+   Étapes 2 et 3 floues avec les poids précalculés, sur les lignes
+   [ \a y0, \a y1 [. Même résultat que unirSimilairesBande.
+*/
+void unirPoidsBande( const PlansTSV* plans, Foret* foret, double floue, int y0, int y1 )
+{
+  if ( floue < 0 ) return;
+  // les poids sont entiers: poids <= floue équivaut à poids <= (int) floue
+  ContextePoids c = { plans, floue > 65535 ? 65535 : (uint32_t) floue };
+  if ( connexiteChoisie() == CONNEXITE_8 )
+    unirPoids8( &c, foret, plans->width, y0, y1 );
+  else
+    unirPoids4( &c, foret, plans->width, y0, y1 );
+}
+
+/**
+   Comme unirPoidsBande, avec les unions sans verrou de
+   foret-concurrente.h: plusieurs threads peuvent réunir en même temps
+   des bandes qui se chevauchent.
+*/
+void unirPoidsBandeConcurrente( const PlansTSV* plans, Foret* foret, double floue, int y0, int y1 )
+{
+  if ( floue < 0 ) return;
+  ContextePoids c = { plans, floue > 65535 ? 65535 : (uint32_t) floue };
+  if ( connexiteChoisie() == CONNEXITE_8 )
+    unirPoidsConcurrents8( &c, foret, plans->width, y0, y1 );
+  else
+    unirPoidsConcurrents4( &c, foret, plans->width, y0, y1 );
+}
+
+void unirPoidsForet( const PlansTSV* plans, Foret* foret, double floue )
+{
+  unirPoidsBande( plans, foret, floue, 0, plans->height );
+}
@@ -0,0 +1,90 @@
+#ifndef PLANS_TSV_H
+#define PLANS_TSV_H
+
+/**
+   Plans TSV précalculés et poids des arêtes pour les composantes floues.
+
+   similitude() convertit ses deux pixels en TSV à chaque appel, soit
+   environ quatre conversions par pixel. Ici on convertit l'image une
+   seule fois en plans t/s/v, puis on calcule en SIMD (AVX2 ou SSE4.1
+   selon les options de compilation, sinon en scalaire) le poids de
+   chaque arête horizontale et verticale. Le poids est exactement
+   similitude() des deux pixels; il est entier, au plus 180 + 5 + 2550.
+   Les unions ne font plus que comparer un poids à floue.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "segmentation.h"
+
+typedef struct PlansTSV {
+  int width;
+  int height;
+  int16_t* t;          // teinte, 0..359
+  uint8_t* s;          // saturation, 0 ou 1 (voir tsv())
+  uint8_t* v;          // valeur, 0..255
+  uint16_t* horizontal; // poids entre i et i + 1 (dernière colonne inutilisée)
+  uint16_t* vertical;   // poids entre i et i + width, (height - 1) * width valeurs
+} PlansTSV;
+
+/**
+   Poids d'une arête, comme similitude(): écart de teinte ramené dans
+   ]-180, 180[, plus 5 fois l'écart de saturation et 10 fois l'écart de valeur.
+*/
+static inline uint16_t poidsScalaire( int t1, int t2, int s1, int s2, int v1, int v2 )
+{
+  int dt = t1 - t2;
+  if ( dt >= 180 ) dt -= 360;
+  else if ( dt <= -180 ) dt += 360;
+  return abs( dt ) + 5 * abs( s1 - s2 ) + 10 * abs( v1 - v2 );
+}
+
+/**
+   Poids de l'arête entre les pixels d'indices \a i et \a j, pour les
+   arêtes qui ne sont pas précalculées (diagonales).
+*/
+static inline uint16_t poidsTSV( const PlansTSV* p, uint32_t i, uint32_t j )
+{
+  return poidsScalaire( p->t[ i ], p->t[ j ], p->s[ i ], p->s[ j ], p->v[ i ], p->v[ j ] );
+}
+
+/// Plus grand poids possible d'une arête.
+#define POIDS_MAX ( 180 + 5 + 10 * 255 )
+
+/**
+   Décalage en x du voisin dans la direction \a d (0 .. 3): droite,
+   dessous, puis les deux diagonales du dessous en 8-connexité.
+*/
+static inline int dxArete( int d )
+{
+  return d == 1 ? 0 : d == 3 ? -1 : 1;
+}
+
+/// Le voisin du pixel \a i dans la direction \a d.
+static inline uint32_t extremiteArete( const PlansTSV* p, uint32_t i, int d )
+{
+  return d == 0 ? i + 1 : i + p->width + dxArete( d );
+}
+
+/// Poids de l'arête de direction \a d qui part du pixel \a i.
+static inline uint16_t poidsArete( const PlansTSV* p, uint32_t i, int d )
+{
+  switch ( d )
+  {
+  case 0:  return p->horizontal[ i ];
+  case 1:  return p->vertical[ i ];
+  default: return poidsTSV( p, i, extremiteArete( p, i, d ) );
+  }
+}
+
+PlansTSV* creerPlansTSV( const Image* img );
+uint32_t* trierAretesTSV( const PlansTSV* plans, Connexite connexite, uint32_t* nb_aretes, uint32_t* debuts );
+void libererPlansTSV( PlansTSV* plans );
+const char* jeuInstructionsPoids( void );
+void poidsAretes( const int16_t* t1, const int16_t* t2, const uint8_t* s1, const uint8_t* s2,
+                  const uint8_t* v1, const uint8_t* v2, uint16_t* poids, int n );
+void unirPoidsBande( const PlansTSV* plans, Foret* foret, double floue, int y0, int y1 );
+void unirPoidsBandeConcurrente( const PlansTSV* plans, Foret* foret, double floue, int y0, int y1 );
+void unirPoidsForet( const PlansTSV* plans, Foret* foret, double floue );
+
+#endif
@@ -0,0 +1,208 @@
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pnm.h"
+
+/**
+   Lit un entier de l'en-tête, en sautant les blancs et les commentaires.
+   Rend -1 en cas d'erreur.
+*/
+static int64_t lireEntierPNM( FILE* f )
+{
+  int c = fgetc( f );
+  while ( c != EOF && ( isspace( c ) || c == '#' ) )
+  {
+    if ( c == '#' )
+      while ( c != EOF && c != '\n' ) c = fgetc( f );
+    c = fgetc( f );
+  }
+  if ( ! isdigit( c ) ) return -1;
+  int64_t n = 0;
+  while ( isdigit( c ) && n < ( INT64_MAX - 9 ) / 10 )
+  {
+    n = 10 * n + ( c - '0' );
+    c = fgetc( f );
+  }
+  // un seul blanc sépare l'en-tête des pixels
+  if ( ! isspace( c ) ) return -1;
+  return n;
+}
+
+/**
+   Lit l'en-tête d'un PGM ou PPM binaire, 8 ou 16 bits. Rend FALSE si le
+   fichier n'en est pas un.
+*/
+bool lireEntetePNM( FILE* f, EntetePNM* entete )
+{
+  if ( fgetc( f ) != 'P' ) return FALSE;
+  int type = fgetc( f );
+  if ( type != '5' && type != '6' ) return FALSE;
+  int64_t width  = lireEntierPNM( f );
+  int64_t height = lireEntierPNM( f );
+  int64_t maxval = lireEntierPNM( f );
+  if ( width <= 0 || width > INT32_MAX / 6 || height <= 0 || maxval <= 0 || maxval > 65535 )
+    return FALSE;
+  entete->width  = (int) width;
+  entete->height = height;
+  entete->canaux = type == '5' ? 1 : 3;
+  entete->maximum = (int) maxval;
+  entete->octets = maxval > 255 ? 2 : 1;
+  return TRUE;
+}
+
+/**
+   Vrai si l'image d'en-tête \a entete tient en mémoire: une Image ou une
+   ImageGrise a une hauteur int, et les étiquettes des composantes sont
+   des uint32_t (une par pixel).
+*/
+bool tientEnMemoirePNM( const EntetePNM* entete )
+{
+  return entete->height <= INT_MAX
+    && (uint64_t) entete->width * entete->height <= UINT32_MAX;
+}
+
+/**
+   Vrai si l'image d'en-tête \a entete peut passer par un Flux: le nombre
+   de pixels, et donc chaque somme de couleurs (255 par pixel au plus),
+   tient sur 64 bits.
+*/
+bool tientEnFluxPNM( const EntetePNM* entete )
+{
+  return (uint64_t) entete->height <= UINT64_MAX / 255 / entete->width;
+}
+
+/**
+   Lit la ligne suivante dans \a ligne (width pixels RGB). Un gris g
+   devient le pixel (g, g, g). Rend FALSE si le fichier est tronqué.
+   Seulement pour les fichiers 8 bits.
+*/
+bool lireLignePNM( FILE* f, const EntetePNM* entete, Pixel* ligne )
+{
+  int width = entete->width;
+  if ( entete->canaux == 3 )
+    return fread( ligne, sizeof( Pixel ), width, f ) == (size_t) width;
+
+  // PGM: on lit les gris dans la fin de la ligne, puis on les étale en
+  // partant de la gauche (l'écriture reste toujours derrière la lecture).
+  unsigned char* gris = (unsigned char*) ligne + 2 * width;
+  if ( fread( gris, 1, width, f ) != (size_t) width ) return FALSE;
+  for ( int x = 0; x < width; ++x )
+    setGreyLevel( &ligne[ x ], gris[ x ] );
+  return TRUE;
+}
+
+/**
+   Vrai si \a filename se termine par .pgm, .ppm ou .pnm.
+*/
+bool estNomPNM( const char* filename )
+{
+  const char* ext = strrchr( filename, '.' );
+  return ext != NULL && ( strcasecmp( ext, ".pgm" ) == 0 || strcasecmp( ext, ".ppm" ) == 0
+                          || strcasecmp( ext, ".pnm" ) == 0 );
+}
+
+/**
+   Projette en lecture seule le PGM/PPM \a filename. Les pixels ne
+   doivent pas être modifiés (ce n'est qu'une entrée). En cas d'échec,
+   errno vaut EFBIG si l'image ne tient pas en mémoire (voir
+   tientEnMemoirePNM), EINVAL si le fichier n'est pas un PGM/PPM ou est
+   tronqué.
+*/
+bool projeterPNM( const char* filename, ImagePNM* img )
+{
+  FILE* f = fopen( filename, "rb" );
+  if ( f == NULL ) return FALSE;
+  bool ok = lireEntetePNM( f, &img->entete );
+  int erreur = ok && ! tientEnMemoirePNM( &img->entete ) ? EFBIG : EINVAL;
+  ok = ok && erreur != EFBIG;
+  long debut = ftell( f );
+  struct stat st;
+  ok = ok && fstat( fileno( f ), &st ) == 0
+    && (uint64_t) st.st_size >= debut + taillePixelsPNM( &img->entete );
+  if ( ok )
+  {
+    img->taille = st.st_size;
+    img->base = (unsigned char*) mmap( NULL, img->taille, PROT_READ, MAP_PRIVATE, fileno( f ), 0 );
+    ok = img->base != MAP_FAILED;
+  }
+  fclose( f );
+  if ( ! ok )
+  {
+    errno = erreur;
+    return FALSE;
+  }
+  img->data = img->base + debut;
+  // les pixels sont lus une fois, dans l'ordre
+  posix_madvise( img->base, img->taille, POSIX_MADV_SEQUENTIAL );
+  return TRUE;
+}
+
+/**
+   Taille en octets des pixels d'un fichier d'en-tête \a entete.
+*/
+size_t taillePixelsPNM( const EntetePNM* entete )
+{
+  return (size_t) entete->width * entete->height * entete->canaux * entete->octets;
+}
+
+/**
+   Crée le PGM (canaux = 1) ou PPM (canaux = 3) \a filename, de la
+   taille et de la profondeur données par \a entete, et le projette en
+   écriture: ce qu'on écrit dans ses pixels arrive dans le fichier à
+   fermerPNM.
+*/
+bool creerPNM( const char* filename, const EntetePNM* entete, ImagePNM* img )
+{
+  char texte[ 64 ];
+  int n = snprintf( texte, sizeof( texte ), "P%c\n%d %d\n%d\n", entete->canaux == 1 ? '5' : '6',
+                    entete->width, (int) entete->height, entete->maximum );
+  int fd = open( filename, O_RDWR | O_CREAT | O_TRUNC, 0666 );
+  if ( fd < 0 ) return FALSE;
+  img->taille = n + taillePixelsPNM( entete );
+  bool ok = ftruncate( fd, img->taille ) == 0;
+  if ( ok )
+  {
+    img->base = (unsigned char*) mmap( NULL, img->taille, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    ok = img->base != MAP_FAILED;
+  }
+  close( fd );
+  if ( ! ok ) return FALSE;
+  memcpy( img->base, texte, n );
+  img->data = img->base + n;
+  img->entete = *entete;
+  return TRUE;
+}
+
+/**
+   Termine la projection (les pixels écrits sont alors dans le fichier).
+*/
+void fermerPNM( ImagePNM* img )
+{
+  munmap( img->base, img->taille );
+  img->base = img->data = NULL;
+}
+
+/**
+   L'Image RGB des pixels d'un PPM 8 bits projeté (sans copie).
+*/
+Image imageDepuisPNM( const ImagePNM* img )
+{
+  Image image = { img->data, img->entete.width, (int) img->entete.height, 3 * img->entete.width, 3 };
+  return image;
+}
+
+/**
+   L'ImageGrise des pixels d'un PGM projeté, 8 ou 16 bits (sans copie).
+*/
+ImageGrise imageGriseDepuisPNM( const ImagePNM* img )
+{
+  const EntetePNM* e = &img->entete;
+  ImageGrise image = { img->data, e->width, (int) e->height, e->width * e->octets, e->octets, e->maximum };
+  return image;
+}
@@ -0,0 +1,50 @@
+#ifndef PNM_H
+#define PNM_H
+
+/**
+   Images PGM (P5) et PPM (P6) binaires, sans passer par gdk-pixbuf.
+   Les échantillons font un octet, ou deux (poids fort en tête) quand
+   la valeur maximale dépasse 255.
+
+   - lecture ligne par ligne, pour les images plus grandes que la
+     mémoire (voir flux.h);
+   - projection en mémoire (mmap) d'un fichier à lire ou à écrire: les
+     pixels du fichier sont directement ceux de l'Image (ou de
+     l'ImageGrise pour un PGM), sans décodage ni copie.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include "segmentation.h"
+#include "gris.h"
+
+typedef struct {
+  int width;
+  int64_t height;
+  int canaux;  // 1 pour un PGM, 3 pour un PPM
+  int maximum; // valeur maximale d'un échantillon (maxval)
+  int octets;  // par échantillon: 1, ou 2 si maximum > 255
+} EntetePNM;
+
+/// Un fichier PGM/PPM projeté en mémoire.
+typedef struct {
+  EntetePNM entete;
+  unsigned char* data;  // premier pixel, dans la projection
+  unsigned char* base;  // début de la projection (en-tête compris)
+  size_t taille;        // taille de la projection
+} ImagePNM;
+
+bool lireEntetePNM( FILE* f, EntetePNM* entete );
+bool tientEnMemoirePNM( const EntetePNM* entete );
+bool tientEnFluxPNM( const EntetePNM* entete );
+bool lireLignePNM( FILE* f, const EntetePNM* entete, Pixel* ligne );
+
+bool estNomPNM( const char* filename );
+bool projeterPNM( const char* filename, ImagePNM* img );
+size_t taillePixelsPNM( const EntetePNM* entete );
+bool creerPNM( const char* filename, const EntetePNM* entete, ImagePNM* img );
+void fermerPNM( ImagePNM* img );
+Image imageDepuisPNM( const ImagePNM* img );
+ImageGrise imageGriseDepuisPNM( const ImagePNM* img );
+
+#endif
@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pyramide.h"
+
+/**
+   Réduit \a src d'un facteur \a f dans \a dst (moyenne de blocs de f x f
+   pixels), pour des pixels de \a canaux octets. Les blocs du bord droit
+   ou du bas qui débordent répètent la dernière colonne ou ligne. Appelée
+   avec f et canaux constants, comme SELON_CANAUX.
+*/
+static inline void reduirePixels( const Image* src, Image* dst, const int f, const int canaux )
+{
+  for ( int y = 0; y < dst->height; ++y )
+  {
+    const unsigned char* lignes[ 4 ];
+    for ( int dy = 0; dy < f; ++dy )
+      lignes[ dy ] = src->data + (size_t) ( f * y + dy < src->height ? f * y + dy : src->height - 1 ) * src->rowstride;
+    unsigned char* out = dst->data + (size_t) y * dst->rowstride;
+    for ( int x = 0; x < dst->width; ++x )
+    {
+      int colonnes[ 4 ];
+      for ( int dx = 0; dx < f; ++dx )
+        colonnes[ dx ] = ( f * x + dx < src->width ? f * x + dx : src->width - 1 ) * canaux;
+      for ( int c = 0; c < canaux; ++c )
+      {
+        int somme = 0;
+        for ( int dy = 0; dy < f; ++dy )
+          for ( int dx = 0; dx < f; ++dx )
+            somme += lignes[ dy ][ colonnes[ dx ] + c ];
+        out[ x * canaux + c ] = ( somme + f * f / 2 ) / ( f * f );
+      }
+    }
+  }
+}
+
+/**
+   Construit la pyramide de \a input: un quart, puis des moitiés
+   successives, jusqu'à un niveau dont les deux côtés font au plus
+   \a cote pixels. Les pixels de \a input ne sont pas copiés et doivent
+   rester valables.
+*/
+Pyramide* creerPyramide( const Image* input, int cote )
+{
+  if ( cote < 1 ) cote = 1;
+  Pyramide* p = (Pyramide*) malloc( sizeof( Pyramide ) );
+  p->nb_niveaux = 1;
+  for ( int w = input->width, h = input->height, f = 4; w > cote || h > cote; f = 2 )
+  {
+    w = ( w + f - 1 ) / f;
+    h = ( h + f - 1 ) / f;
+    p->nb_niveaux++;
+  }
+  p->niveaux = (Image*) malloc( p->nb_niveaux * sizeof( Image ) );
+  p->sorties = (Image*) calloc( p->nb_niveaux, sizeof( Image ) );
+  p->plans = (PlansTSV**) calloc( p->nb_niveaux, sizeof( PlansTSV* ) );
+  p->niveaux[ 0 ] = *input;
+  for ( int k = 1; k < p->nb_niveaux; ++k )
+  {
+    const Image* fin = &p->niveaux[ k - 1 ];
+    Image* niveau = &p->niveaux[ k ];
+    int f = k == 1 ? 4 : 2;
+    niveau->width = ( fin->width + f - 1 ) / f;
+    niveau->height = ( fin->height + f - 1 ) / f;
+    niveau->canaux = fin->canaux;
+    niveau->rowstride = niveau->width * niveau->canaux;
+    niveau->data = (unsigned char*) malloc( (size_t) niveau->rowstride * niveau->height );
+    if ( f == 4 ) SELON_CANAUX( niveau, reduirePixels( fin, niveau, 4, canaux ) );
+    else          SELON_CANAUX( niveau, reduirePixels( fin, niveau, 2, canaux ) );
+    // La sortie part de l'entrée, pour en garder l'alpha.
+    p->sorties[ k ] = *niveau;
+    p->sorties[ k ].data = (unsigned char*) malloc( (size_t) niveau->rowstride * niveau->height );
+    memcpy( p->sorties[ k ].data, niveau->data, (size_t) niveau->rowstride * niveau->height );
+  }
+  return p;
+}
+
+void libererPyramide( Pyramide* p )
+{
+  if ( p == NULL ) return;
+  for ( int k = 1; k < p->nb_niveaux; ++k )
+  {
+    free( p->niveaux[ k ].data );
+    free( p->sorties[ k ].data );
+    libererPlansTSV( p->plans[ k ] );
+  }
+  free( p->niveaux );
+  free( p->sorties );
+  free( p->plans );
+  free( p );
+}
+
+/**
+   Segmente en composantes floues chaque niveau de la pyramide sauf la
+   pleine résolution, du plus grossier au plus fin, et passe chaque
+   résultat à \a apercu. Les tampons sont ceux du calcul final: leur
+   suivi (suivreTampons) peut interrompre les aperçus, qui rendent
+   alors FALSE.
+*/
+bool apercusFloues( Pyramide* p, double floue, Tampons* tampons,
+                    FonctionApercu apercu, void* data )
+{
+  for ( int k = p->nb_niveaux - 1; k >= 1; --k )
+  {
+    if ( p->plans[ k ] == NULL )
+      p->plans[ k ] = creerPlansTSV( &p->niveaux[ k ] );
+    if ( ! calculerComposantesConnexesFlouesPlans( &p->niveaux[ k ], &p->sorties[ k ], p->plans[ k ],
+                                                   floue, tampons ) )
+      return FALSE;
+    apercu( &p->sorties[ k ], k, data );
+  }
+  return TRUE;
+}
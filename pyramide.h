@@ -0,0 +1,51 @@
+#ifndef PYRAMIDE_H
+#define PYRAMIDE_H
+
+/**
+   Aperçus progressifs des composantes floues, du grossier au fin.
+
+   Sur une grande image, composantesConnexesFloues ne montre rien avant
+   la fin du calcul en pleine résolution. La pyramide garde l'entrée
+   réduite au quart (moyenne de 4x4 pixels), puis de moitié en moitié
+   (2x2), jusqu'à un côté d'au plus COTE_APERCU pixels, avec les plans
+   TSV de chaque niveau. Un aperçu à la moitié coûterait déjà le quart
+   du calcul final, pour une image à peine plus nette que le quart.
+   apercusFloues segmente le niveau le plus grossier, le livre aussitôt
+   à l'appelant, puis passe au niveau suivant, plus fin; la pleine
+   résolution reste le calcul habituel.
+
+   Les aperçus ne servent qu'à l'affichage: le résultat final n'en
+   dépend pas et reste exactement celui de
+   calculerComposantesConnexesFlouesPlans. Les unions d'un niveau
+   grossier ne sont pas reprises au niveau suivant: deux pixels moyens
+   proches ne disent rien des pixels fins qu'ils résument, et une
+   forêt amorcée par le niveau grossier réunirait des pixels que le
+   calcul exact sépare.
+*/
+
+#include "segmentation.h"
+#include "plans-tsv.h"
+#include "tampons.h"
+
+/// Côté maximal, en pixels, du niveau le plus grossier.
+#define COTE_APERCU 128
+
+typedef struct {
+  int nb_niveaux;       // niveau 0: l'entrée, 1: son quart, puis des moitiés
+  Image* niveaux;       // niveaux[ 0 ] pointe sur les pixels de l'entrée
+  Image* sorties;       // composantes de chaque niveau (sauf 0)
+  PlansTSV** plans;     // plans de chaque niveau (sauf 0), au premier usage
+} Pyramide;
+
+/**
+   Reçoit l'aperçu \a apercu du niveau \a niveau (ses dimensions sont
+   celles du niveau), valable jusqu'au retour.
+*/
+typedef void (*FonctionApercu)( const Image* apercu, int niveau, void* data );
+
+Pyramide* creerPyramide( const Image* input, int cote );
+void libererPyramide( Pyramide* pyramide );
+bool apercusFloues( Pyramide* pyramide, double floue, Tampons* tampons,
+                    FonctionApercu apercu, void* data );
+
+#endif
@@ -0,0 +1,376 @@
+#include <stdlib.h>
+#include <string.h>
+#include "regions.h"
+#include "foret.h"
+#include "plans-tsv.h"
+
+/**
+   Arête du graphe des régions: deux régions (ou des régions qui ont
+   fusionné depuis dans a et b) et leur coût au moment où l'arête a été
+   empilée. Une arête revue a déjà été réempilée à son coût à jour.
+*/
+typedef struct {
+  double cout;
+  uint32_t a;
+  uint32_t b;
+  uint32_t revue;
+} Arete;
+
+/// Tas binaire des arêtes, du coût le plus faible au plus fort.
+typedef struct {
+  Arete* aretes;
+  size_t nb;
+  size_t capacite;
+} Tas;
+
+static void descendre( Tas* tas, size_t i )
+{
+  Arete* t = tas->aretes;
+  Arete x = t[ i ];
+  for ( ;; )
+  {
+    size_t f = 2 * i + 1;
+    if ( f >= tas->nb ) break;
+    if ( f + 1 < tas->nb && t[ f + 1 ].cout < t[ f ].cout ) ++f;
+    if ( t[ f ].cout >= x.cout ) break;
+    t[ i ] = t[ f ];
+    i = f;
+  }
+  t[ i ] = x;
+}
+
+static void empiler( Tas* tas, Arete arete )
+{
+  if ( tas->nb == tas->capacite )
+  {
+    tas->capacite = 2 * tas->capacite + 1024;
+    tas->aretes = (Arete*) realloc( tas->aretes, tas->capacite * sizeof( Arete ) );
+  }
+  Arete* t = tas->aretes;
+  size_t i = tas->nb++;
+  while ( i > 0 && t[ ( i - 1 ) / 2 ].cout > arete.cout )
+  {
+    t[ i ] = t[ ( i - 1 ) / 2 ];
+    i = ( i - 1 ) / 2;
+  }
+  t[ i ] = arete;
+}
+
+/**
+   Retire du tas les arêtes entre deux régions qui ont fusionné depuis,
+   puis le reconstruit.
+*/
+static void nettoyer( Tas* tas, Foret* regions )
+{
+  size_t n = 0;
+  for ( size_t k = 0; k < tas->nb; ++k )
+  {
+    Arete a = tas->aretes[ k ];
+    if ( foretTrouver( regions, a.a ) != foretTrouver( regions, a.b ) )
+      tas->aretes[ n++ ] = a;
+  }
+  tas->nb = n;
+  for ( size_t k = n / 2; k-- > 0; )
+    descendre( tas, k );
+}
+
+static Arete depiler( Tas* tas )
+{
+  Arete min = tas->aretes[ 0 ];
+  tas->aretes[ 0 ] = tas->aretes[ --tas->nb ];
+  if ( tas->nb > 0 ) descendre( tas, 0 );
+  return min;
+}
+
+/// Couleur moyenne, tronquée comme moyennerComposantes.
+static Pixel couleurMoyenne( const SommeCouleur* s )
+{
+  Pixel p;
+  p.rouge = s->rouge / s->nb;
+  p.vert  = s->vert  / s->nb;
+  p.bleu  = s->bleu  / s->nb;
+  return p;
+}
+
+/**
+   Couleur moyenne d'une région en TSV, et son nombre de pixels: tout ce
+   qu'il faut pour le coût d'une fusion, recalculé seulement quand la
+   région grossit.
+*/
+typedef struct {
+  int16_t t;
+  uint8_t s;
+  uint8_t v;
+  uint32_t nb;
+} Moyenne;
+
+static Moyenne moyenne( const SommeCouleur* s )
+{
+  Pixel p = couleurMoyenne( s );
+  TSVCouleur c = tsv( &p );
+  Moyenne m = { (int16_t) c.t, (uint8_t) c.s, (uint8_t) c.v, s->nb };
+  return m;
+}
+
+/// similitude() des couleurs moyennes, fois na nb / ( na + nb ).
+static double coutFusion( Moyenne a, Moyenne b )
+{
+  double na = a.nb, nb = b.nb;
+  return poidsScalaire( a.t, b.t, a.s, b.s, a.v, b.v ) * na * nb / ( na + nb );
+}
+
+/// Paires de régions voisines, codées ( min << 32 ) | max.
+typedef struct {
+  uint64_t* paires;
+  size_t nb;
+  size_t capacite;
+} Paires;
+
+/**
+   Note la paire { \a e, \a f } si les deux étiquettes diffèrent. Le
+   long d'une frontière, la même paire revient à chaque pixel: on ne la
+   note pas deux fois de suite.
+*/
+static inline void noterPaire( Paires* p, uint32_t e, uint32_t f )
+{
+  if ( e == f ) return;
+  uint64_t paire = e < f ? (uint64_t) e << 32 | f : (uint64_t) f << 32 | e;
+  if ( p->nb > 0 && p->paires[ p->nb - 1 ] == paire ) return;
+  if ( p->nb == p->capacite )
+  {
+    p->capacite = 2 * p->capacite + 1024;
+    p->paires = (uint64_t*) realloc( p->paires, p->capacite * sizeof( uint64_t ) );
+  }
+  p->paires[ p->nb++ ] = paire;
+}
+
+static int comparerPaires( const void* p, const void* q )
+{
+  uint64_t a = *(const uint64_t*) p, b = *(const uint64_t*) q;
+  return ( a > b ) - ( a < b );
+}
+
+/**
+   Paires de régions voisines dans la connexité choisie, triées et sans
+   doublon, un voisin à la fois pour que les doublons se suivent.
+*/
+static void voisinages( const uint32_t* etiquettes, int width, int height, Paires* p )
+{
+  static const int DX[ 4 ] = { 1, 0, 1, -1 };
+  static const int DY[ 4 ] = { 0, 1, 1, 1 };
+  int nb_voisins = connexiteChoisie() == CONNEXITE_8 ? 4 : 2;
+  for ( int d = 0; d < nb_voisins; ++d )
+    for ( int y = 0; y + DY[ d ] < height; ++y )
+    {
+      const uint32_t* ligne = etiquettes + (size_t) y * width;
+      const uint32_t* voisine = ligne + (size_t) DY[ d ] * width + DX[ d ];
+      int x0 = DX[ d ] < 0 ? 1 : 0;
+      int x1 = DX[ d ] > 0 ? width - 1 : width;
+      for ( int x = x0; x < x1; ++x )
+        noterPaire( p, ligne[ x ], voisine[ x ] );
+    }
+  qsort( p->paires, p->nb, sizeof( uint64_t ), comparerPaires );
+  size_t n = 0;
+  for ( size_t k = 0; k < p->nb; ++k )
+    if ( n == 0 || p->paires[ n - 1 ] != p->paires[ k ] )
+      p->paires[ n++ ] = p->paires[ k ];
+  p->nb = n;
+}
+
+/// Voisins d'une région (des régions qui ont pu fusionner depuis).
+typedef struct {
+  uint32_t* ids;
+  uint32_t nb;
+  uint32_t capacite;
+} Voisins;
+
+static void ajouterVoisin( Voisins* v, uint32_t id )
+{
+  if ( v->nb == v->capacite )
+  {
+    v->capacite = v->capacite == 0 ? 4 : 2 * v->capacite;
+    v->ids = (uint32_t*) realloc( v->ids, v->capacite * sizeof( uint32_t ) );
+  }
+  v->ids[ v->nb++ ] = id;
+}
+
+/**
+   Met dans \a v les voisins de \a v et de \a autre, en recopiant la
+   plus courte des deux listes au bout de l'autre. \a autre est vidée.
+   Rend l'indice, dans \a v, du premier voisin recopié.
+*/
+static uint32_t fusionnerVoisins( Voisins* v, Voisins* autre )
+{
+  if ( autre->nb > v->nb )
+  {
+    Voisins t = *v;
+    *v = *autre;
+    *autre = t;
+  }
+  uint32_t debut = v->nb;
+  for ( uint32_t k = 0; k < autre->nb; ++k )
+    ajouterVoisin( v, autre->ids[ k ] );
+  free( autre->ids );
+  autre->ids = NULL;
+  autre->nb = autre->capacite = 0;
+  return debut;
+}
+
+/**
+   Quand le tas est vide, des paires de régions voisines ont pu passer
+   sous la tolérance sans y avoir d'arête (leur coût a baissé après
+   qu'elles en sont sorties). Empile toutes les paires voisines de
+   \a paires, ramenées à leurs racines, dont le coût est sous
+   \a tolerance, et rend TRUE s'il y en a.
+*/
+static bool reprendrePaires( Tas* tas, const Paires* paires, Foret* regions, const Moyenne* moyennes,
+                             double tolerance )
+{
+  for ( size_t k = 0; k < paires->nb; ++k )
+  {
+    uint32_t a = foretTrouver( regions, (uint32_t) ( paires->paires[ k ] >> 32 ) );
+    uint32_t b = foretTrouver( regions, (uint32_t) paires->paires[ k ] );
+    if ( a == b ) continue;
+    Arete arete = { coutFusion( moyennes[ a ], moyennes[ b ] ), a, b, FALSE };
+    if ( arete.cout <= tolerance ) empiler( tas, arete );
+  }
+  return tas->nb > 0;
+}
+
+/**
+   Fusionne les régions voisines de la dernière segmentation faite avec
+   \a tampons (étiquettes et sommes des couleurs, voir tampons.h), par
+   coût croissant (voir regions.h), jusqu'à ce qu'il ne reste que \a
+   nb_regions régions ou que le coût dépasse \a tolerance
+   (TOLERANCE_INFINIE pour ne s'arrêter qu'au nombre de régions, 0 pour
+   ne s'arrêter qu'à la tolérance). Chaque région fusionnée de \a output
+   prend sa couleur moyenne; les étiquettes (compactes, dans l'ordre de
+   lecture), les sommes, les couleurs et la table éventuelle des
+   tampons décrivent les régions fusionnées, comme après une
+   segmentation: on peut refusionner. Rend le nombre de régions.
+*/
+uint32_t fusionnerRegions( Image* output, Tampons* tampons, double tolerance, uint32_t nb_regions )
+{
+  int width = output->width, height = output->height;
+  uint32_t taille = (uint32_t) width * height;
+  uint32_t* etiquettes = tampons->etiquettes;
+  SommeCouleur* sommes = tampons->sommes;
+  uint32_t nb = 0;
+  for ( uint32_t i = 0; i < taille; ++i )
+    if ( etiquettes[ i ] >= nb ) nb = etiquettes[ i ] + 1;
+
+  // Graphe d'adjacence: liste des voisins de chaque région, et tas
+  // initial de toutes ses arêtes.
+  Paires paires = { NULL, 0, 0 };
+  voisinages( etiquettes, width, height, &paires );
+  Voisins* voisins = (Voisins*) calloc( nb, sizeof( Voisins ) );
+  Moyenne* moyennes = (Moyenne*) malloc( nb * sizeof( Moyenne ) );
+  for ( uint32_t e = 0; e < nb; ++e )
+    moyennes[ e ] = moyenne( &sommes[ e ] );
+  Tas tas;
+  tas.capacite = paires.nb + 1;
+  tas.aretes = (Arete*) malloc( tas.capacite * sizeof( Arete ) );
+  tas.nb = 0;
+  for ( size_t k = 0; k < paires.nb; ++k )
+  {
+    uint32_t a = (uint32_t) ( paires.paires[ k ] >> 32 );
+    uint32_t b = (uint32_t) paires.paires[ k ];
+    ajouterVoisin( &voisins[ a ], b );
+    ajouterVoisin( &voisins[ b ], a );
+    Arete arete = { coutFusion( moyennes[ a ], moyennes[ b ] ), a, b, FALSE };
+    if ( arete.cout <= tolerance ) tas.aretes[ tas.nb++ ] = arete;
+  }
+  for ( size_t k = tas.nb / 2; k-- > 0; )
+    descendre( &tas, k );
+
+  // Fusions, dans une forêt sur les régions. Une arête qui sort du tas
+  // est ramenée à ses racines et son coût recalculé: au-dessus de la
+  // tolérance, elle est oubliée; s'il a changé depuis qu'elle a été
+  // empilée et n'est plus le plus faible du tas, elle y retourne une
+  // fois avec son coût à jour. Les arêtes
+  // au-dessus de la tolérance n'y entrent pas: elles arrêteraient tout.
+  Foret* regions = creerForet( nb );
+  uint32_t restantes = nb;
+  size_t limite = 2 * tas.nb + 1024;
+  while ( restantes > nb_regions
+          && ( tas.nb > 0 || reprendrePaires( &tas, &paires, regions, moyennes, tolerance ) ) )
+  {
+    Arete arete = depiler( &tas );
+    uint32_t a = foretTrouver( regions, arete.a );
+    uint32_t b = foretTrouver( regions, arete.b );
+    if ( a == b ) continue;
+    double cout = coutFusion( moyennes[ a ], moyennes[ b ] );
+    if ( cout > tolerance ) continue;
+    if ( cout != arete.cout && ! arete.revue && tas.nb > 0 && cout > tas.aretes[ 0 ].cout )
+    {
+      Arete actuelle = { cout, a, b, TRUE };
+      empiler( &tas, actuelle );
+      continue;
+    }
+    foretUnion( regions, a, b );
+    uint32_t r = regions->pere[ a ] == a ? a : b;
+    uint32_t autre = r == a ? b : a;
+    sommes[ r ].rouge += sommes[ autre ].rouge;
+    sommes[ r ].vert  += sommes[ autre ].vert;
+    sommes[ r ].bleu  += sommes[ autre ].bleu;
+    sommes[ r ].nb    += sommes[ autre ].nb;
+    moyennes[ r ] = moyenne( &sommes[ r ] );
+    restantes--;
+    // Seuls les voisins de la plus courte des deux listes reçoivent une
+    // arête à jour; ceux de l'autre gardent la leur, revue à sa sortie
+    // du tas. Chaque voisin n'est ainsi recopié et réempilé qu'en
+    // rejoignant une liste au moins deux fois plus longue.
+    Voisins* v = &voisins[ r ];
+    uint32_t debut = fusionnerVoisins( v, &voisins[ autre ] );
+    for ( uint32_t k = debut; k < v->nb; ++k )
+    {
+      uint32_t w = foretTrouver( regions, v->ids[ k ] );
+      if ( w == r ) continue;
+      Arete actuelle = { coutFusion( moyennes[ r ], moyennes[ w ] ), r, w, FALSE };
+      if ( actuelle.cout <= tolerance ) empiler( &tas, actuelle );
+    }
+    if ( tas.nb > limite )
+    {
+      nettoyer( &tas, regions );
+      limite = 2 * tas.nb + 1024;
+    }
+  }
+  free( paires.paires );
+  for ( uint32_t e = 0; e < nb; ++e )
+    free( voisins[ e ].ids );
+  free( voisins );
+  free( tas.aretes );
+  free( moyennes );
+
+  // Nouvelles étiquettes compactes, dans l'ordre de lecture; les sommes
+  // des racines sont recopiées à leur nouvelle étiquette.
+  SommeCouleur* anciennes = (SommeCouleur*) malloc( nb * sizeof( SommeCouleur ) );
+  memcpy( anciennes, sommes, nb * sizeof( SommeCouleur ) );
+  uint32_t* nouvelle = (uint32_t*) malloc( nb * sizeof( uint32_t ) );
+  memset( nouvelle, 0xff, nb * sizeof( uint32_t ) );
+  TableComposantes* table = tampons->table;
+  if ( table != NULL ) commencerTable( table, width, height );
+  uint32_t nb_final = 0;
+  uint32_t i = 0;
+  for ( int y = 0; y < height; ++y )
+    for ( int x = 0; x < width; ++x, ++i )
+    {
+      uint32_t r = foretTrouver( regions, etiquettes[ i ] );
+      if ( nouvelle[ r ] == UINT32_MAX )
+      {
+        nouvelle[ r ] = nb_final;
+        sommes[ nb_final ] = anciennes[ r ];
+        tampons->couleurs[ nb_final ] = couleurMoyenne( &anciennes[ r ] );
+        if ( table != NULL ) ajouterComposante( table, x, y );
+        nb_final++;
+      }
+      etiquettes[ i ] = nouvelle[ r ];
+      if ( table != NULL ) mesurerPixel( table, etiquettes, etiquettes[ i ], x, y, i );
+    }
+  free( nouvelle );
+  free( anciennes );
+  libererForet( regions );
+  if ( table != NULL ) terminerTable( table, etiquettes, tampons->couleurs );
+  peindreComposantes( output, tampons, 0, height );
+  return nb_final;
+}
@@ -0,0 +1,766 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "segmentation.h"
+#include "parallele.h"
+#include "plages.h"
+#include "plans-tsv.h"
+#include "tampons.h"
+#include "foret-concurrente.h"
+#include "seuillage.h"
+
+/// Nombre de threads des composantes connexes (1: calcul séquentiel).
+static int nombreThreads = 1;
+/// Unions multi-threads sur une forêt partagée (foret-concurrente.h) plutôt que par bandes.
+static bool unionsConcurrentes = FALSE;
+/// Moteur de calcul des composantes connexes (non floues).
+static MoteurComposantes moteurComposantes = COMPOSANTES_PAR_PIXELS;
+/// Voisinage des composantes connexes.
+static Connexite connexite = CONNEXITE_4;
+
+/**
+   Retourne le niveau de gris du pixel.
+*/
+unsigned char greyLevel( Pixel* data )
+{
+  return (data->rouge+data->vert+data->bleu)/3;
+}
+
+/**
+   Met le pixel au niveau de gris \a g.
+*/
+void setGreyLevel( Pixel* data, unsigned char g )
+{
+  data->rouge = g;
+  data->vert  = g;
+  data->bleu  = g;
+}
+
+/**
+   Va au pixel de coordonnées (x,y) dans l'image.
+*/
+Pixel* pixelImage( const Image* img, int x, int y )
+{
+  return (Pixel*)( img->data + y*img->rowstride + x*img->canaux );
+}
+
+/**
+   Choisit le nombre de threads utilisés par les composantes connexes.
+*/
+void choisirNombreThreads( int nb_threads )
+{
+  nombreThreads = nb_threads < 1 ? 1 : nb_threads;
+}
+
+/**
+   Avec plusieurs threads, fait les unions sans verrou sur une seule
+   forêt partagée (foret-concurrente.h), plutôt que par bandes
+   indépendantes suivies d'une réunion séquentielle des frontières.
+*/
+void choisirUnionsConcurrentes( bool concurrentes )
+{
+  unionsConcurrentes = concurrentes;
+}
+
+/**
+   Choisit le moteur de calculerComposantesConnexes: union pixel par
+   pixel ou par plages (plages.h).
+*/
+void choisirMoteurComposantes( MoteurComposantes moteur )
+{
+  moteurComposantes = moteur;
+}
+
+MoteurComposantes moteurComposantesChoisi( void )
+{
+  return moteurComposantes;
+}
+
+/**
+   Choisit le voisinage (4 ou 8 voisins) de toutes les composantes connexes.
+*/
+void choisirConnexite( Connexite c )
+{
+  connexite = c;
+}
+
+Connexite connexiteChoisie( void )
+{
+  return connexite;
+}
+
+/**
+   Seuille l'image \a input dans \a output (de même format): noir en
+   dessous de \a seuil, blanc sinon.
+*/
+void seuiller( const Image* input, Image* output, int seuil )
+{
+  seuillerNiveaux( input, output, &seuil, 1, NULL );
+}
+
+/**
+   Étapes 2 et 3: réunit les pixels voisins de même niveau de gris avec \a unir.
+*/
+void unirNiveauxDeGris( const Image* output, Objet* objects, FonctionUnion unir )
+{
+  int size = ( output->width ) * ( output->height );
+
+  for(int i = 0 /*2*/; i < size; i++)
+  {
+    // 3a
+    bool isLastColumn = (i % output->width) == output->width - 1;
+    if(!isLastColumn && greyLevel(objects[i].pixel) == greyLevel(objects[i+1].pixel))
+      unir(&objects[i], &objects[i+1]);
+    // 3b
+    bool isLastLine = i >= (size - output->width);
+    if( !isLastLine && greyLevel(objects[i].pixel) == greyLevel(objects[i+output->width].pixel))
+      unir(&objects[i],&objects[i+output->width]);
+  }
+}
+
+/**
+   Étapes 2 et 3 floues: réunit les pixels voisins dont la similitude
+   est inférieure à \a floue.
+*/
+void unirSimilaires( const Image* output, Objet* objects, double floue, FonctionUnion unir )
+{
+  int size = ( output->width ) * ( output->height );
+
+  for(int i = 0 /*2*/; i < size; i++)
+  {
+    // 3a
+    bool isLastColumn = (i % output->width) == output->width - 1;
+    if(!isLastColumn && similitude(objects[ i ].pixel, objects[ i+1 ].pixel) <= floue)
+      unir(&objects[ i ], &objects[ i+1 ]);
+    // 3b
+    bool isLastLine = i >= (size - output->width);
+    if( !isLastLine && similitude(objects[ i ].pixel, objects[ i + output->width ].pixel) <= floue)
+      unir(&objects[ i ], &objects[ i + output->width ]);
+  }
+}
+
+#ifdef INSTRUMENTATION
+/**
+   Analyse (instrumentation.h) de la forêt d'Objet à la fin des unions.
+   Les rangs des Objet partent de 1.
+*/
+static void analyserObjets( Objet* objects, int size )
+{
+  uint32_t* pere = (uint32_t*) calloc( size, sizeof( uint32_t ) );
+  uint8_t* rang = (uint8_t*) calloc( size, 1 );
+  for ( int i = 0; i < size; ++i )
+  {
+    pere[ i ] = (uint32_t) ( objects[ i ].pere - objects );
+    rang[ i ] = objects[ i ].rang - 1 < 255 ? objects[ i ].rang - 1 : 255;
+  }
+  instrumentationAnalyserForet( pere, rang, size );
+  free( rang );
+  free( pere );
+}
+#endif
+
+/**
+   Étapes 4 à 6: somme les couleurs de \a input sur chaque représentant.
+   Le tableau retourné est à libérer avec free.
+*/
+StatCouleur* calculerStats( const Image* input, const Image* output, Objet* objects )
+{
+  int size = ( output->width ) * ( output->height );
+  INSTRUMENTER( analyserObjets( objects, size ); )
+
+  // 4 & 5
+  StatCouleur *stats = (StatCouleur*) calloc( size, sizeof(StatCouleur) );
+
+  // 6
+  for ( int i = 0; i < size; ++i )
+  {
+    Objet* rep = trouver( &objects[ i ] ); // tu trouve le représentant
+    long int j = rep - objects; // tu trouve sons indice dans les tableaux
+    Pixel* pixel_src = (Pixel*) ( input->data + ( (unsigned char*) objects[ i ].pixel - output->data ) );
+    // pixel_src est la couleur de ce pixel dans l'image input.
+    // On l'ajoute à la stat du représentant j.
+    stats[ j ].rouge += pixel_src->rouge;
+    stats[ j ].vert  += pixel_src->vert;
+    stats[ j ].bleu  += pixel_src->bleu;
+    stats[ j ].nb += 1; // On aura donc la somme cumulée
+  }
+  return stats;
+}
+
+/**
+   Étapes 7 et 8: colorie chaque composante avec sa couleur moyenne.
+*/
+void repeindreComposantes( const Image* output, Objet* objects, StatCouleur* stats )
+{
+  int size = ( output->width ) * ( output->height );
+
+  // 7
+  for ( int i = 0; i < size; ++i )
+  {
+    // C'est un représentant
+    if (stats[ i ].nb != 0) {
+      objects[ i ].pixel->rouge = stats[ i ].rouge / stats[ i ].nb;
+      objects[ i ].pixel->vert  = stats[ i ].vert  / stats[ i ].nb;
+      objects[ i ].pixel->bleu  = stats[ i ].bleu  / stats[ i ].nb;
+    }
+  }
+
+  // 8
+  for ( int i = 0; i < size; ++i )
+  {
+    Objet* rep = trouver( &objects[ i ] ); // tu trouve le représentant
+    objects[ i ].pixel->rouge = rep->pixel->rouge;
+    objects[ i ].pixel->bleu  = rep->pixel->bleu;
+    objects[ i ].pixel->vert  = rep->pixel->vert;
+  }
+}
+
+/// Données des noyaux d'unions sur une image RGB ou RGBA (voir noyau-unions.h).
+typedef struct {
+  const Image* img;
+  double floue;
+} ContexteRGB;
+
+// Les noyaux sont générés pour chaque format de pixel: NOYAU_CANAUX
+// vaut 3 (RGB) ou 4 (RGBA).
+#define NOYAU_CONTEXTE ContexteRGB
+#define NOYAU_LIGNE( c, y )                                             \
+  unsigned char* ligne = c->img->data + (size_t) y * c->img->rowstride; \
+  unsigned char* dessous = y + 1 < c->img->height ? ligne + c->img->rowstride : ligne;
+#define PIXEL_RGB( x ) PIXEL_LIGNE( ligne, x, NOYAU_CANAUX )
+#define VOISIN_RGB( dx, dy ) \
+  PIXEL_LIGNE( (dy) ? dessous : ligne, x + (dx), NOYAU_CANAUX )
+
+// Même niveau de gris
+#define NOYAU_PIXEL( c, x ) unsigned char g = greyLevel( PIXEL_RGB( x ) );
+#define NOYAU_PREDICAT( c, x, i, dx, dy ) ( g == greyLevel( VOISIN_RGB( dx, dy ) ) )
+#define NOYAU_CANAUX 3
+#define NOYAU_NOM unirNiveauxDeGris4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirNiveauxDeGris8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_CANAUX
+#define NOYAU_CANAUX 4
+#define NOYAU_NOM unirNiveauxDeGrisRGBA4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirNiveauxDeGrisRGBA8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_CANAUX
+// Mêmes noyaux sur une forêt partagée entre threads
+#define NOYAU_UNION foretUnionConcurrente
+#define NOYAU_CANAUX 3
+#define NOYAU_NOM unirNiveauxDeGrisConcurrents4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirNiveauxDeGrisConcurrents8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_CANAUX
+#define NOYAU_CANAUX 4
+#define NOYAU_NOM unirNiveauxDeGrisConcurrentsRGBA4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirNiveauxDeGrisConcurrentsRGBA8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_CANAUX
+#undef NOYAU_UNION
+#undef NOYAU_PREDICAT
+#undef NOYAU_PIXEL
+
+// Similitude au plus floue
+#define NOYAU_PIXEL( c, x )
+#define NOYAU_PREDICAT( c, x, i, dx, dy ) ( similitude( PIXEL_RGB( x ), VOISIN_RGB( dx, dy ) ) <= c->floue )
+#define NOYAU_CANAUX 3
+#define NOYAU_NOM unirSimilaires4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirSimilaires8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_CANAUX
+#define NOYAU_CANAUX 4
+#define NOYAU_NOM unirSimilairesRGBA4
+#define NOYAU_VOISINAGE VOISINAGE_4
+#include "noyau-unions.h"
+#define NOYAU_NOM unirSimilairesRGBA8
+#define NOYAU_VOISINAGE VOISINAGE_8
+#include "noyau-unions.h"
+#undef NOYAU_CANAUX
+#undef NOYAU_PREDICAT
+#undef NOYAU_PIXEL
+#undef VOISIN_RGB
+#undef PIXEL_RGB
+#undef NOYAU_LIGNE
+#undef NOYAU_CONTEXTE
+
+/// Type des noyaux générés ci-dessus.
+typedef void (*NoyauRGB)( const ContexteRGB* c, Foret* foret, int width, int y0, int y1 );
+
+/**
+   Le noyau à appliquer à \a img parmi ceux d'un même prédicat, donnés
+   pour RGB puis RGBA, en 4 puis 8-connexité.
+*/
+static NoyauRGB choisirNoyau( const Image* img, NoyauRGB rgb4, NoyauRGB rgb8, NoyauRGB rgba4, NoyauRGB rgba8 )
+{
+  if ( img->canaux == 4 )
+    return connexite == CONNEXITE_8 ? rgba8 : rgba4;
+  return connexite == CONNEXITE_8 ? rgb8 : rgb4;
+}
+
+/**
+   Étapes 2 et 3 sur une forêt compacte, restreintes aux lignes
+   [ \a y0, \a y1 [: réunit les pixels voisins de même niveau de gris.
+   Les unions ne touchent que les pixels de la bande.
+*/
+void unirNiveauxDeGrisBande( const Image* output, Foret* foret, int y0, int y1 )
+{
+  ContexteRGB c = { output, 0.0 };
+  NoyauRGB noyau = choisirNoyau( output, unirNiveauxDeGris4, unirNiveauxDeGris8,
+                                 unirNiveauxDeGrisRGBA4, unirNiveauxDeGrisRGBA8 );
+  noyau( &c, foret, output->width, y0, y1 );
+}
+
+/**
+   Comme unirNiveauxDeGrisBande, avec les unions sans verrou de
+   foret-concurrente.h: plusieurs threads peuvent réunir en même temps
+   des bandes qui se chevauchent.
+*/
+void unirNiveauxDeGrisBandeConcurrente( const Image* output, Foret* foret, int y0, int y1 )
+{
+  ContexteRGB c = { output, 0.0 };
+  NoyauRGB noyau = choisirNoyau( output, unirNiveauxDeGrisConcurrents4, unirNiveauxDeGrisConcurrents8,
+                                 unirNiveauxDeGrisConcurrentsRGBA4, unirNiveauxDeGrisConcurrentsRGBA8 );
+  noyau( &c, foret, output->width, y0, y1 );
+}
+
+/**
+   Étapes 2 et 3 floues sur une forêt compacte, restreintes aux lignes
+   [ \a y0, \a y1 [.
+*/
+void unirSimilairesBande( const Image* output, Foret* foret, double floue, int y0, int y1 )
+{
+  ContexteRGB c = { output, floue };
+  NoyauRGB noyau = choisirNoyau( output, unirSimilaires4, unirSimilaires8,
+                                 unirSimilairesRGBA4, unirSimilairesRGBA8 );
+  noyau( &c, foret, output->width, y0, y1 );
+}
+
+/**
+   Étapes 2 et 3 sur une forêt compacte: réunit les pixels voisins de
+   même niveau de gris.
+*/
+void unirNiveauxDeGrisForet( const Image* output, Foret* foret )
+{
+  unirNiveauxDeGrisBande( output, foret, 0, output->height );
+}
+
+/**
+   Étapes 2 et 3 floues sur une forêt compacte.
+*/
+void unirSimilairesForet( const Image* output, Foret* foret, double floue )
+{
+  unirSimilairesBande( output, foret, floue, 0, output->height );
+}
+
+/**
+   Étapes 4 à 6 sur une forêt compacte: somme les couleurs de \a input
+   sur chaque racine. Le tableau retourné est à libérer avec free.
+*/
+StatCouleur* calculerStatsForet( const Image* input, Foret* foret )
+{
+  INSTRUMENTER( instrumentationAnalyserForet( foret->pere, foret->rang, foret->taille ); )
+  StatCouleur* stats = (StatCouleur*) calloc( foret->taille, sizeof( StatCouleur ) );
+  uint32_t i = 0;
+  for ( int y = 0; y < input->height; ++y )
+  {
+    Pixel* ligne = pixelImage( input, 0, y );
+    for ( int x = 0; x < input->width; ++x, ++i )
+    {
+      uint32_t j = foretTrouver( foret, i );
+      Pixel* pixel_src = PIXEL_LIGNE( ligne, x, input->canaux );
+      stats[ j ].rouge += pixel_src->rouge;
+      stats[ j ].vert  += pixel_src->vert;
+      stats[ j ].bleu  += pixel_src->bleu;
+      stats[ j ].nb += 1;
+    }
+  }
+  return stats;
+}
+
+/**
+   Étapes 7 et 8 sur une forêt compacte: colorie chaque composante de
+   \a output avec sa couleur moyenne.
+*/
+void repeindreForet( Image* output, Foret* foret, StatCouleur* stats )
+{
+  int width = output->width;
+  // 7
+  for ( uint32_t i = 0; i < foret->taille; ++i )
+    if ( stats[ i ].nb != 0 )
+    {
+      Pixel* rep = pixelImage( output, i % width, i / width );
+      rep->rouge = stats[ i ].rouge / stats[ i ].nb;
+      rep->vert  = stats[ i ].vert  / stats[ i ].nb;
+      rep->bleu  = stats[ i ].bleu  / stats[ i ].nb;
+    }
+
+  // 8
+  uint32_t i = 0;
+  for ( int y = 0; y < output->height; ++y )
+  {
+    Pixel* ligne = pixelImage( output, 0, y );
+    for ( int x = 0; x < width; ++x, ++i )
+    {
+      uint32_t j = foretTrouver( foret, i );
+      if ( j != i )
+        *PIXEL_LIGNE( ligne, x, output->canaux ) = *pixelImage( output, j % width, j / width );
+    }
+  }
+}
+
+/**
+   Découpe \a output (typiquement l'image seuillée) en composantes de
+   même niveau de gris, puis colorie chacune avec la couleur moyenne
+   correspondante dans \a input.
+*/
+void calculerComposantesConnexes( const Image* input, Image* output )
+{
+  Tampons* tampons = creerTampons();
+  calculerComposantesConnexesTampons( input, output, tampons );
+  libererTampons( tampons );
+}
+
+/**
+   Étapes 4 à 8 sur la forêt de \a tampons, en annonçant chaque phase.
+   Rend FALSE si le calcul a été interrompu avant de toucher \a output.
+*/
+bool colorierPhases( const Image* input, Image* output, Tampons* tampons )
+{
+  if ( ! annoncerPhase( tampons, AVANCEMENT_STATS ) ) return FALSE;
+  uint32_t nb = nombreThreads > 1
+    ? sommerComposantesParallele( input, tampons, nombreThreads )
+    : sommerComposantes( input, tampons );
+  if ( ! annoncerPhase( tampons, AVANCEMENT_REPEINT ) ) return FALSE;
+  if ( nombreThreads > 1 )
+    peindreComposantesParallele( output, tampons, nb, nombreThreads );
+  else
+  {
+    moyennerComposantes( tampons, nb );
+    peindreComposantes( output, tampons, 0, output->height );
+  }
+  if ( tampons->table != NULL )
+    terminerTable( tampons->table, tampons->etiquettes, tampons->couleurs );
+  annoncerPhase( tampons, AVANCEMENT_FINI );
+  return TRUE;
+}
+
+/**
+   Comme calculerComposantesConnexes, avec des tampons gardés d'un appel
+   à l'autre (voir tampons.h). Rend FALSE si le suivi des tampons a
+   interrompu le calcul.
+*/
+bool calculerComposantesConnexesTampons( const Image* input, Image* output, Tampons* tampons )
+{
+  if ( ! annoncerPhase( tampons, AVANCEMENT_UNIONS ) ) return FALSE;
+  // Les plages n'ont pas d'étiquette par pixel: la table passe par les pixels.
+  if ( moteurComposantes == COMPOSANTES_PAR_PLAGES && tampons->table == NULL )
+  {
+    composantesParPlages( input, output );
+    annoncerPhase( tampons, AVANCEMENT_FINI );
+    return TRUE;
+  }
+  // 1
+  Foret* foret = preparerTampons( tampons, (uint32_t) output->width * output->height );
+  if ( nombreThreads > 1 && unionsConcurrentes )
+    unirNiveauxDeGrisConcurrents( output, foret, nombreThreads );
+  else if ( nombreThreads > 1 )
+    unirNiveauxDeGrisParallele( output, foret, nombreThreads );
+  else
+    unirNiveauxDeGrisForet( output, foret );
+  return colorierPhases( input, output, tampons );
+}
+
+/**
+   Regroupe les pixels voisins de \a input dont la similitude est
+   inférieure à \a floue et colorie chaque composante de \a output avec
+   sa couleur moyenne. Tout \a output est réécrit: inutile d'y recopier
+   l'entrée au préalable.
+*/
+void calculerComposantesConnexesFloues( const Image* input, Image* output, double floue )
+{
+  PlansTSV* plans = creerPlansTSV( input );
+  Tampons* tampons = creerTampons();
+  calculerComposantesConnexesFlouesPlans( input, output, plans, floue, tampons );
+  libererTampons( tampons );
+  libererPlansTSV( plans );
+}
+
+/**
+   Comme calculerComposantesConnexesFloues, avec les plans TSV de \a input
+   déjà calculés (on peut les garder d'un appel à l'autre tant que
+   l'entrée ne change pas) et des tampons réutilisés. Rend FALSE si le
+   suivi des tampons a interrompu le calcul.
+*/
+bool calculerComposantesConnexesFlouesPlans( const Image* input, Image* output,
+                                             const PlansTSV* plans, double floue, Tampons* tampons )
+{
+  if ( ! annoncerPhase( tampons, AVANCEMENT_UNIONS ) ) return FALSE;
+  // 1
+  Foret* foret = preparerTampons( tampons, (uint32_t) output->width * output->height );
+  if ( nombreThreads > 1 && unionsConcurrentes )
+    unirSimilairesConcurrents( plans, foret, floue, nombreThreads );
+  else if ( nombreThreads > 1 )
+    unirSimilairesParallele( output, plans, foret, floue, nombreThreads );
+  else
+    unirPoidsForet( plans, foret, floue );
+  return colorierPhases( input, output, tampons );
+}
+
+/**
+   Creer un objet par pixel
+ */
+Objet* creerEnsembles( Image* img )
+{
+  unsigned char* data = img->data;
+
+  Objet *objects = (Objet*) malloc(img->width*img->height*sizeof(Objet));
+  int cpt_obj = 0;
+
+  for ( int y = 0; y < img->height; ++y )
+  {
+    for ( int x = 0; x < img->width; ++x )
+    {
+      objects[cpt_obj].pixel = PIXEL_LIGNE( data, x, img->canaux );
+      objects[cpt_obj].rang = 1;
+      objects[cpt_obj].pere = &objects[cpt_obj];
+
+      cpt_obj++;
+    }
+    data += img->rowstride;
+  }
+
+  return objects;
+}
+
+/// Méthode de recherche utilisée par trouver(), choisie à la compilation
+/// (-DTROUVER_DEFAUT_FONCTION=...) ou à l'exécution (choisirMethodeTrouver).
+static FonctionTrouver trouverCourant = TROUVER_DEFAUT_FONCTION;
+
+Objet* trouverPasOpti( Objet* object )
+{
+  // itératif: la récursion débordait la pile sur les grandes images
+  while ( object != object->pere )
+  {
+    object = object->pere;
+    INSTRUMENTER( compterPas(); )
+  }
+  INSTRUMENTER( compterTrouver(); )
+  return object;
+}
+
+Objet* trouverOpti( Objet* obj )
+{
+  if (obj != obj->pere)
+  {
+    INSTRUMENTER( compterPas(); )
+    obj->pere = trouverOpti( obj->pere);
+  }
+
+  return obj->pere;
+}
+
+/**
+   Compression de chemin complète en deux passes: on remonte jusqu'à la
+   racine, puis on refait le chemin pour y rattacher chaque objet. Même
+   résultat que trouverOpti, mais sans récursion.
+*/
+Objet* trouverDeuxPasses( Objet* obj )
+{
+  Objet* racine = obj;
+  while ( racine != racine->pere )
+  {
+    racine = racine->pere;
+    INSTRUMENTER( compterPas(); )
+  }
+  while ( obj != racine )
+  {
+    Objet* suivant = obj->pere;
+    obj->pere = racine;
+    obj = suivant;
+  }
+  return racine;
+}
+
+/**
+   Demi-chemin (path halving): chaque objet visité sur deux pointe vers
+   son grand-père. Une seule passe.
+*/
+Objet* trouverDemiChemin( Objet* obj )
+{
+  while ( obj != obj->pere )
+  {
+    obj->pere = obj->pere->pere;
+    obj = obj->pere;
+    INSTRUMENTER( compterPas(); )
+  }
+  return obj;
+}
+
+/**
+   Scission de chemin (path splitting): chaque objet visité pointe vers
+   son grand-père. Une seule passe.
+*/
+Objet* trouverScission( Objet* obj )
+{
+  while ( obj != obj->pere )
+  {
+    Objet* suivant = obj->pere;
+    obj->pere = suivant->pere;
+    obj = suivant;
+    INSTRUMENTER( compterPas(); )
+  }
+  return obj;
+}
+
+/**
+   Trouve le représentant avec la méthode choisie.
+*/
+Objet* trouver( Objet* obj )
+{
+  Objet* racine = trouverCourant( obj );
+  INSTRUMENTER( compterTrouver(); )
+  return racine;
+}
+
+void choisirMethodeTrouver( MethodeTrouver methode )
+{
+  switch ( methode )
+  {
+  case TROUVER_RECURSIF:    trouverCourant = trouverOpti; break;
+  case TROUVER_DEUX_PASSES: trouverCourant = trouverDeuxPasses; break;
+  case TROUVER_DEMI_CHEMIN: trouverCourant = trouverDemiChemin; break;
+  case TROUVER_SCISSION:    trouverCourant = trouverScission; break;
+  }
+}
+
+/**
+   Retourne la méthode de nom \a nom ("recursif", "deux-passes",
+   "demi-chemin", "scission"), ou -1 si elle est inconnue.
+*/
+int methodeTrouverDepuisNom( const char* nom )
+{
+  if ( strcmp( nom, "recursif" ) == 0 )    return TROUVER_RECURSIF;
+  if ( strcmp( nom, "deux-passes" ) == 0 ) return TROUVER_DEUX_PASSES;
+  if ( strcmp( nom, "demi-chemin" ) == 0 ) return TROUVER_DEMI_CHEMIN;
+  if ( strcmp( nom, "scission" ) == 0 )    return TROUVER_SCISSION;
+  return -1;
+}
+
+void unionPasOpti(Objet* obj1, Objet* obj2)
+{
+  Objet* u = trouverPasOpti( obj1 );
+  Objet* y = trouverPasOpti( obj2 );
+  INSTRUMENTER( compterUnion( u != y ); )
+  u->pere = y;
+}
+
+/**
+   Union avec compression de chemin seulement (sans rang).
+*/
+void unionCompression( Objet* obj1, Objet* obj2 )
+{
+  Objet* u = trouver( obj1 );
+  Objet* v = trouver( obj2 );
+  INSTRUMENTER( compterUnion( u != v ); )
+  u->pere = v;
+}
+
+/**
+   Union par rang seulement (recherche sans compression de chemin).
+*/
+void unionRang( Objet* obj1, Objet* obj2 )
+{
+  Objet* u = trouverPasOpti(obj1);
+  Objet* v = trouverPasOpti(obj2);
+
+  INSTRUMENTER( compterUnion( u != v ); )
+  if (u == v) return;
+  if (u->rang > v->rang)
+    v->pere = u;
+  else
+    u->pere = v;
+
+  if (u->rang == v->rang)
+    v->rang = v->rang + 1;
+}
+
+void unionOpti( Objet* obj1, Objet* obj2 )
+{
+  Objet* u = trouver(obj1);
+  Objet* v = trouver(obj2);
+
+  INSTRUMENTER( compterUnion( u != v ); )
+  if (u->rang > v->rang)
+    v->pere = u;
+  else
+    u->pere = v;
+
+  if (u->rang == v->rang)
+    v->rang = v->rang + 1;
+}
+
+TSVCouleur tsv(Pixel* pixel)
+{
+  TSVCouleur tsv;
+
+  unsigned char max = fmaxf(fmaxf(pixel->bleu, pixel->rouge), pixel->vert);
+  unsigned char min = fminf(fminf(pixel->bleu, pixel->rouge), pixel->vert);
+
+  // pour t
+  if (min == max)
+  {
+    tsv.t = 0;
+  }
+  else if (max == pixel->rouge)
+  {
+    tsv.t = ( 60 * (pixel->vert - pixel->bleu) / (max - min) + 360 ) % 360;
+  }
+  else if (max == pixel->vert)
+  {
+    tsv.t = 60 * ((pixel->bleu - pixel->rouge) / (max - min)) + 120;
+  }
+  else if (max == pixel->bleu)
+  {
+    tsv.t = 60 * ((pixel->rouge - pixel->vert) / (max - min)) + 240;
+  }
+
+  // pour s
+  if (max == 0)
+  {
+    tsv.s = 0;
+  }
+  else
+  {
+    tsv.s = 1 - (min / max);
+  }
+
+  // pour v
+  tsv.v = max;
+
+  return tsv;
+}
+
+double similitude( Pixel* p1, Pixel* p2 )
+{
+  TSVCouleur tsv1 = tsv( p1 );
+  TSVCouleur tsv2 = tsv( p2 );
+  int diff = tsv1.t - tsv2.t;
+  while ( diff >= 180 ) diff -= 360;
+  while ( diff <= -180 ) diff += 360;
+  return abs( (double) diff ) + 5.0 * abs( tsv1.s - tsv2.s ) + 10.0 * abs( tsv1.v - tsv2.v );
+}
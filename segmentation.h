@@ -0,0 +1,208 @@
+#ifndef SEGMENTATION_H
+#define SEGMENTATION_H
+
+/**
+   Algorithmes de segmentation (seuillage, composantes connexes,
+   composantes connexes floues) indépendants de GTK. Ils travaillent
+   sur une simple description d'un tampon de pixels (Image), ce qui
+   permet de les appeler aussi bien depuis l'IHM que depuis le mode
+   batch sans affichage.
+*/
+
+#include "foret.h"
+
+#ifndef bool
+#define bool int
+#endif
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+//-----------------------------------------------------------------------------
+// Déclaration des types
+//-----------------------------------------------------------------------------
+/**
+   Un pixel est une structure de 3 octets (rouge, vert, bleu). On les
+   plaque au bon endroit dans un pixbuf pour modifier les couleurs du pixel.
+ */
+typedef struct {
+  unsigned char rouge;
+  unsigned char vert;
+  unsigned char bleu;
+} Pixel;
+
+/**
+   Une image est un tampon de pixels RGB (3 octets) ou RGBA (4 octets),
+   ligne par ligne: le format est celui du fichier chargé, sans
+   conversion. Pour passer d'une ligne à la suivante on ajoute
+   \a rowstride octets. L'alpha n'entre dans aucun calcul et n'est
+   jamais écrit: une sortie garde celui de son tampon.
+   Le tampon n'appartient pas à l'Image (c'est souvent celui d'un GdkPixbuf).
+ */
+typedef struct {
+  unsigned char* data;
+  int width;
+  int height;
+  int rowstride;
+  int canaux;    // octets par pixel: 3 (RGB) ou 4 (RGBA)
+} Image;
+
+/**
+   Le pixel \a x de la ligne \a ligne, dont les pixels font \a canaux
+   octets. Les boucles sur les pixels sont écrites pour un \a canaux
+   constant (3 ou 4) et appelées pour chacun des deux formats, que le
+   compilateur spécialise: voir SELON_CANAUX.
+*/
+#define PIXEL_LIGNE( ligne, x, canaux ) \
+  ( (Pixel*) ( (unsigned char*) (ligne) + (size_t) (x) * (canaux) ) )
+
+/**
+   Évalue \a appel, où figure le paramètre canaux, avec canaux
+   remplacé par la constante 3 ou 4 selon le format de \a img.
+*/
+#define SELON_CANAUX( img, appel )      \
+  do {                                  \
+    if ( (img)->canaux == 4 )           \
+    {                                   \
+      enum { canaux = 4 };              \
+      appel;                            \
+    }                                   \
+    else                                \
+    {                                   \
+      enum { canaux = 3 };              \
+      appel;                            \
+    }                                   \
+  } while ( 0 )
+
+/**
+   Un Objet est un un wrapper d'un pixel permettant l'organisation en forêt.
+   Un pixel a maintenant un rang et un père.
+   Un ancètre dont le père est lui même s'appelle la racine.
+   Les composantes connexes utilisent maintenant la Foret compacte de
+   foret.h; les Objet restent pour les variantes du banc d'essai.
+ */
+typedef struct SObjet {
+  Pixel* pixel; // adresse du pixel dans le pixbuf
+  int rang;
+  struct SObjet* pere;
+} Objet;
+
+/**
+  structure pour stocker la moyenne des couleurs
+*/
+typedef struct {
+  double rouge;
+  double vert;
+  double bleu;
+  int nb;
+} StatCouleur;
+
+/**
+  structure de couleur au format TSV
+*/
+typedef struct {
+  int t;    // teinte comme angle en degrés
+  double s; // saturation comme nombre entre 0 et 1
+  double v; // valeur ou brillance comme nombre entre 0 et 1
+} TSVCouleur;
+
+/**
+   Fonction d'union de deux ensembles (unionPasOpti, unionOpti, ...).
+*/
+typedef void (*FonctionUnion)( Objet* obj1, Objet* obj2 );
+
+/**
+   Fonction de recherche du représentant (trouverOpti, trouverDemiChemin, ...).
+*/
+typedef Objet* (*FonctionTrouver)( Objet* obj );
+
+/**
+   Méthodes de recherche du représentant avec compression de chemin.
+   Seule TROUVER_RECURSIF (trouverOpti) utilise une pile proportionnelle
+   à la hauteur de l'arbre.
+*/
+typedef enum {
+  TROUVER_RECURSIF,    // trouverOpti
+  TROUVER_DEUX_PASSES, // trouverDeuxPasses
+  TROUVER_DEMI_CHEMIN, // trouverDemiChemin
+  TROUVER_SCISSION     // trouverScission
+} MethodeTrouver;
+
+/**
+   Moteurs de calcul des composantes connexes de même niveau de gris.
+*/
+typedef enum {
+  COMPOSANTES_PAR_PIXELS, // une union par paire de pixels voisins
+  COMPOSANTES_PAR_PLAGES  // une union par paire de plages voisines (plages.h)
+} MoteurComposantes;
+
+/**
+   Voisinage des composantes connexes: 4 voisins (gauche, droite, haut,
+   bas) ou 8 (avec les diagonales). Voir noyau-unions.h.
+*/
+typedef enum {
+  CONNEXITE_4,
+  CONNEXITE_8
+} Connexite;
+
+/// Méthode par défaut, modifiable avec -DTROUVER_DEFAUT_FONCTION=trouverScission par exemple.
+#ifndef TROUVER_DEFAUT_FONCTION
+#define TROUVER_DEFAUT_FONCTION trouverDeuxPasses
+#endif
+
+//-----------------------------------------------------------------------------
+// Déclaration des fonctions
+//-----------------------------------------------------------------------------
+unsigned char greyLevel( Pixel* data );
+void setGreyLevel( Pixel* data, unsigned char g );
+Pixel* pixelImage( const Image* img, int x, int y );
+
+Objet* creerEnsembles( Image* img );
+Objet* trouverPasOpti( Objet* obj );
+void unionPasOpti( Objet* obj1, Objet* obj2 );
+Objet* trouverOpti( Objet* obj );
+Objet* trouverDeuxPasses( Objet* obj );
+Objet* trouverDemiChemin( Objet* obj );
+Objet* trouverScission( Objet* obj );
+Objet* trouver( Objet* obj );
+void choisirMethodeTrouver( MethodeTrouver methode );
+int methodeTrouverDepuisNom( const char* nom );
+void unionCompression( Objet* obj1, Objet* obj2 );
+void unionRang( Objet* obj1, Objet* obj2 );
+void unionOpti( Objet* obj1, Objet* obj2 );
+TSVCouleur tsv( Pixel* pixel );
+double similitude( Pixel* p1, Pixel* p2 );
+
+void unirNiveauxDeGris( const Image* output, Objet* objects, FonctionUnion unir );
+void unirSimilaires( const Image* output, Objet* objects, double floue, FonctionUnion unir );
+StatCouleur* calculerStats( const Image* input, const Image* output, Objet* objects );
+void repeindreComposantes( const Image* output, Objet* objects, StatCouleur* stats );
+
+void unirNiveauxDeGrisBande( const Image* output, Foret* foret, int y0, int y1 );
+void unirNiveauxDeGrisBandeConcurrente( const Image* output, Foret* foret, int y0, int y1 );
+void unirSimilairesBande( const Image* output, Foret* foret, double floue, int y0, int y1 );
+void unirNiveauxDeGrisForet( const Image* output, Foret* foret );
+void unirSimilairesForet( const Image* output, Foret* foret, double floue );
+StatCouleur* calculerStatsForet( const Image* input, Foret* foret );
+void repeindreForet( Image* output, Foret* foret, StatCouleur* stats );
+
+void choisirNombreThreads( int nb_threads );
+void choisirUnionsConcurrentes( bool concurrentes );
+void choisirMoteurComposantes( MoteurComposantes moteur );
+MoteurComposantes moteurComposantesChoisi( void );
+void choisirConnexite( Connexite c );
+Connexite connexiteChoisie( void );
+void seuiller( const Image* input, Image* output, int seuil );
+void calculerComposantesConnexes( const Image* input, Image* output );
+void calculerComposantesConnexesFloues( const Image* input, Image* output, double floue );
+
+struct PlansTSV;
+struct Tampons;
+bool calculerComposantesConnexesTampons( const Image* input, Image* output, struct Tampons* tampons );
+bool colorierPhases( const Image* input, Image* output, struct Tampons* tampons );
+bool calculerComposantesConnexesFlouesPlans( const Image* input, Image* output,
+                                             const struct PlansTSV* plans, double floue,
+                                             struct Tampons* tampons );
+
+#endif
@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sequence.h"
+
+Sequence* creerSequence( int hauteur_bande )
+{
+  Sequence* sequence = (Sequence*) calloc( 1, sizeof( Sequence ) );
+  sequence->hauteur_bande = hauteur_bande > 0 ? hauteur_bande : HAUTEUR_BANDE_SEQUENCE;
+  sequence->tampons = creerTampons();
+  return sequence;
+}
+
+void libererSequence( Sequence* sequence )
+{
+  if ( sequence == NULL ) return;
+  free( sequence->empreintes );
+  free( sequence->foret.pere );
+  free( sequence->foret.rang );
+  libererTampons( sequence->tampons );
+  free( sequence );
+}
+
+/**
+   La prochaine image sera calculée entièrement, sans rien reprendre de
+   la précédente.
+*/
+void oublierSequence( Sequence* sequence )
+{
+  sequence->valide = FALSE;
+}
+
+/**
+   Empreinte FNV-1a des \a n octets de \a p, mot de 64 bits par mot de
+   64 bits.
+*/
+static uint64_t empreinteLigne( const unsigned char* p, size_t n )
+{
+  uint64_t h = 0xcbf29ce484222325ULL;
+  size_t k = 0;
+  for ( ; k + 8 <= n; k += 8 )
+  {
+    uint64_t mot;
+    memcpy( &mot, p + k, 8 );
+    h = ( h ^ mot ) * 0x100000001b3ULL;
+  }
+  for ( ; k < n; ++k )
+    h = ( h ^ p[ k ] ) * 0x100000001b3ULL;
+  return h;
+}
+
+/// Réalloue la forêt des bandes et les empreintes pour \a width x \a height.
+static void redimensionnerSequence( Sequence* sequence, int width, int height )
+{
+  uint32_t taille = (uint32_t) width * height;
+  free( sequence->empreintes );
+  free( sequence->foret.pere );
+  free( sequence->foret.rang );
+  sequence->empreintes = (uint64_t*) malloc( height * sizeof( uint64_t ) );
+  sequence->foret.pere = (uint32_t*) malloc( taille * sizeof( uint32_t ) );
+  sequence->foret.rang = (uint8_t*) malloc( taille * sizeof( uint8_t ) );
+  sequence->foret.taille = taille;
+  sequence->width = width;
+  sequence->height = height;
+  sequence->nb_bandes = ( height + sequence->hauteur_bande - 1 ) / sequence->hauteur_bande;
+  sequence->valide = FALSE;
+}
+
+/// Unions des lignes [ y0, y1 [ de \a comparee, selon floue (voir segmenterImageSequence).
+static void unirLignes( const Image* comparee, Foret* foret, double floue, int y0, int y1 )
+{
+  if ( floue < 0.0 )
+    unirNiveauxDeGrisBande( comparee, foret, y0, y1 );
+  else
+    unirSimilairesBande( comparee, foret, floue, y0, y1 );
+}
+
+/**
+   Segmente l'image suivante de la séquence. Avec \a floue négative, ce
+   sont les composantes de même gris de \a output (seuillée par
+   l'appelant), comme calculerComposantesConnexes; sinon les composantes
+   floues de \a input, comme calculerComposantesConnexesFloues. Chaque
+   composante de \a output prend la couleur moyenne de \a input.
+
+   Rend le nombre de bandes dont les unions ont été refaites, ou -1 si
+   le suivi des tampons a interrompu le calcul (\a output n'est alors
+   pas touchée, et la forêt des bandes reste celle de cette image).
+*/
+int segmenterImageSequence( Sequence* sequence, const Image* input, Image* output, double floue )
+{
+  const Image* comparee = floue < 0.0 ? output : input;
+  Tampons* tampons = sequence->tampons;
+  if ( ! annoncerPhase( tampons, AVANCEMENT_UNIONS ) ) return -1;
+  if ( input->width != sequence->width || input->height != sequence->height )
+    redimensionnerSequence( sequence, input->width, input->height );
+  if ( floue != sequence->floue || connexiteChoisie() != sequence->connexite )
+    sequence->valide = FALSE;
+  sequence->floue = floue;
+  sequence->connexite = connexiteChoisie();
+
+  // Bandes dont une ligne a changé: remises en singletons et réunies.
+  int width = input->width;
+  int refaites = 0;
+  for ( int b = 0; b < sequence->nb_bandes; ++b )
+  {
+    int y0 = b * sequence->hauteur_bande;
+    int y1 = y0 + sequence->hauteur_bande < input->height ? y0 + sequence->hauteur_bande : input->height;
+    bool changee = ! sequence->valide;
+    for ( int y = y0; y < y1; ++y )
+    {
+      uint64_t e = empreinteLigne( comparee->data + (size_t) y * comparee->rowstride, (size_t) comparee->canaux * width );
+      changee = changee || e != sequence->empreintes[ y ];
+      sequence->empreintes[ y ] = e;
+    }
+    if ( ! changee ) continue;
+    uint32_t debut = (uint32_t) y0 * width, fin = (uint32_t) y1 * width;
+    for ( uint32_t i = debut; i < fin; ++i )
+      sequence->foret.pere[ i ] = i;
+    memset( sequence->foret.rang + debut, 0, fin - debut );
+    unirLignes( comparee, &sequence->foret, floue, y0, y1 );
+    refaites++;
+  }
+  sequence->valide = TRUE;
+  sequence->nb_images += 1;
+  sequence->bandes_refaites += refaites;
+  sequence->bandes_gardees += sequence->nb_bandes - refaites;
+
+  // Forêt complète: celle des bandes, plus les unions des frontières.
+  Foret* foret = preparerTampons( tampons, sequence->foret.taille );
+  memcpy( foret->pere, sequence->foret.pere, foret->taille * sizeof( uint32_t ) );
+  memcpy( foret->rang, sequence->foret.rang, foret->taille * sizeof( uint8_t ) );
+  for ( int b = 1; b < sequence->nb_bandes; ++b )
+  {
+    int y = b * sequence->hauteur_bande;
+    unirLignes( comparee, foret, floue, y - 1, y + 1 );
+  }
+  if ( ! colorierPhases( input, output, tampons ) ) return -1;
+  return refaites;
+}
@@ -0,0 +1,50 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+/**
+   Segmentation incrémentale d'une suite d'images (animation, vidéo).
+
+   L'image est découpée en bandes horizontales de hauteur_bande lignes,
+   comme pour les threads (parallele.h). Les unions internes à chaque
+   bande sont gardées d'une image à l'autre dans une forêt à part. Une
+   empreinte de chaque ligne dit quelles bandes ont changé depuis
+   l'image précédente : seules celles-là sont remises en singletons et
+   réunies de nouveau. Pour chaque image, on copie ensuite cette forêt
+   dans les tampons, on refait les unions le long des frontières (deux
+   lignes par frontière) et on colorie comme d'habitude.
+
+   Le résultat est celui d'un calcul complet de chaque image (à une
+   collision d'empreintes 64 bits près). Changer la floue, la connexité
+   ou la taille de l'image refait toutes les bandes.
+*/
+
+#include <stdint.h>
+#include "segmentation.h"
+#include "foret.h"
+#include "tampons.h"
+
+/// Hauteur des bandes par défaut, en lignes.
+#define HAUTEUR_BANDE_SEQUENCE 16
+
+typedef struct {
+  int width;
+  int height;
+  int hauteur_bande;
+  int nb_bandes;
+  uint64_t* empreintes; // empreinte de chaque ligne de l'image précédente
+  Foret foret;          // unions internes aux bandes seulement
+  double floue;         // réglages de l'image précédente
+  Connexite connexite;
+  bool valide;          // FALSE: toutes les bandes sont à refaire
+  Tampons* tampons;     // forêt complète, étiquettes et couleurs
+  uint64_t nb_images;
+  uint64_t bandes_refaites;
+  uint64_t bandes_gardees;
+} Sequence;
+
+Sequence* creerSequence( int hauteur_bande );
+void libererSequence( Sequence* sequence );
+void oublierSequence( Sequence* sequence );
+int segmenterImageSequence( Sequence* sequence, const Image* input, Image* output, double floue );
+
+#endif
@@ -0,0 +1,271 @@
+#include <stdlib.h>
+#include <string.h>
+#include "seuillage.h"
+#if defined( __SSSE3__ )
+#include <immintrin.h>
+#endif
+
+/**
+   Seuils ramenés aux gris: ceux qui sont <= 0 mettent tous les pixels
+   une classe plus haut (base), ceux qui sont > 255 ne servent pas.
+*/
+typedef struct {
+  int nb;                          // seuils utiles, dans 1..255
+  unsigned char seuils[ CLASSES_MAX ];
+  unsigned char niveaux[ CLASSES_MAX ]; // gris écrit quand g dépasse j seuils utiles
+  unsigned char table[ 256 ];           // gris écrit pour chaque gris lu
+} Seuils;
+
+static void preparerSeuils( Seuils* s, const int* seuils, int nb_seuils )
+{
+  int base = 0;
+  s->nb = 0;
+  for ( int k = 0; k < nb_seuils; ++k )
+    if ( seuils[ k ] <= 0 ) ++base;
+    else if ( seuils[ k ] <= 255 ) s->seuils[ s->nb++ ] = seuils[ k ];
+  memset( s->niveaux, 0, sizeof( s->niveaux ) );
+  for ( int j = 0; j <= s->nb; ++j )
+    s->niveaux[ j ] = ( base + j ) * 255 / nb_seuils;
+  for ( int g = 0; g < 256; ++g )
+  {
+    int j = 0;
+    for ( int k = 0; k < s->nb; ++k )
+      j += g >= s->seuils[ k ];
+    s->table[ g ] = s->niveaux[ j ];
+  }
+}
+
+#if defined( __SSSE3__ )
+/**
+   Gris de 16 pixels de 4 octets (p0: pixels 0..3, ..., p3: 12..15),
+   dont le quatrième octet est ignoré.
+*/
+static inline __m128i grisSSSE3( __m128i p0, __m128i p1, __m128i p2, __m128i p3 )
+{
+  // ( r + v, b ) par pixel, puis r + v + b
+  const __m128i poids = _mm_set1_epi32( 0x00010101 );
+  __m128i s0 = _mm_hadd_epi16( _mm_maddubs_epi16( p0, poids ), _mm_maddubs_epi16( p1, poids ) );
+  __m128i s1 = _mm_hadd_epi16( _mm_maddubs_epi16( p2, poids ), _mm_maddubs_epi16( p3, poids ) );
+  // ( r + v + b ) / 3 = ( r + v + b ) * 0xaaab >> 17
+  const __m128i tiers = _mm_set1_epi16( (short) 0xaaab );
+  s0 = _mm_srli_epi16( _mm_mulhi_epu16( s0, tiers ), 1 );
+  s1 = _mm_srli_epi16( _mm_mulhi_epu16( s1, tiers ), 1 );
+  return _mm_packus_epi16( s0, s1 );
+}
+
+/// Gris des 16 pixels de \a canaux octets qui commencent en \a p.
+static inline __m128i lireGris16( const unsigned char* p, const int canaux )
+{
+  if ( canaux == 4 )
+    return grisSSSE3( _mm_loadu_si128( (const __m128i*) p ),
+                      _mm_loadu_si128( (const __m128i*) ( p + 16 ) ),
+                      _mm_loadu_si128( (const __m128i*) ( p + 32 ) ),
+                      _mm_loadu_si128( (const __m128i*) ( p + 48 ) ) );
+  // 48 octets RGB, redécoupés en 4 fois 4 pixels de 4 octets
+  const __m128i vers4 = _mm_setr_epi8( 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+  __m128i a = _mm_loadu_si128( (const __m128i*) p );
+  __m128i b = _mm_loadu_si128( (const __m128i*) ( p + 16 ) );
+  __m128i c = _mm_loadu_si128( (const __m128i*) ( p + 32 ) );
+  return grisSSSE3( _mm_shuffle_epi8( a, vers4 ),
+                    _mm_shuffle_epi8( _mm_alignr_epi8( b, a, 12 ), vers4 ),
+                    _mm_shuffle_epi8( _mm_alignr_epi8( c, b, 8 ), vers4 ),
+                    _mm_shuffle_epi8( _mm_srli_si128( c, 4 ), vers4 ) );
+}
+
+/**
+   Écrit les 16 gris de \a o dans les 16 pixels de \a canaux octets qui
+   commencent en \a p. En RGBA, l'alpha de la sortie est gardé.
+*/
+static inline void ecrireGris16( unsigned char* p, __m128i o, const int canaux )
+{
+  if ( canaux == 4 )
+  {
+    const __m128i alpha = _mm_set1_epi32( (int) 0xff000000 );
+    for ( int k = 0; k < 4; ++k )
+    {
+      __m128i m = _mm_setr_epi8( 4 * k, 4 * k, 4 * k, -1, 4 * k + 1, 4 * k + 1, 4 * k + 1, -1,
+                                 4 * k + 2, 4 * k + 2, 4 * k + 2, -1, 4 * k + 3, 4 * k + 3, 4 * k + 3, -1 );
+      __m128i* q = (__m128i*) ( p + 16 * k );
+      _mm_storeu_si128( q, _mm_or_si128( _mm_shuffle_epi8( o, m ),
+                                         _mm_and_si128( _mm_loadu_si128( q ), alpha ) ) );
+    }
+    return;
+  }
+  _mm_storeu_si128( (__m128i*) p,
+                    _mm_shuffle_epi8( o, _mm_setr_epi8( 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5 ) ) );
+  _mm_storeu_si128( (__m128i*) ( p + 16 ),
+                    _mm_shuffle_epi8( o, _mm_setr_epi8( 5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10 ) ) );
+  _mm_storeu_si128( (__m128i*) ( p + 32 ),
+                    _mm_shuffle_epi8( o, _mm_setr_epi8( 10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15 ) ) );
+}
+#endif
+
+/**
+   Seuille \a input dans \a output (ou rien si \a output est NULL) et
+   compte les gris dans \a histo (ou pas s'il est NULL), pour des pixels
+   de \a canaux octets. Quatre histogrammes, remplis à tour de rôle:
+   deux pixels voisins de même gris n'attendent pas l'un sur l'autre.
+*/
+static inline void seuillerPixels( const Image* input, Image* output, const Seuils* s,
+                                   uint32_t histo[ 4 ][ 256 ], const int canaux )
+{
+#if defined( __SSSE3__ )
+  const __m128i niveaux = _mm_loadu_si128( (const __m128i*) s->niveaux );
+  __m128i seuils[ CLASSES_MAX ];
+  for ( int k = 0; k < s->nb; ++k )
+    seuils[ k ] = _mm_set1_epi8( (char) s->seuils[ k ] );
+#endif
+  for ( int y = 0; y < input->height; ++y )
+  {
+    const unsigned char* in = input->data + (size_t) y * input->rowstride;
+    unsigned char* out = output != NULL ? output->data + (size_t) y * output->rowstride : NULL;
+    int x = 0;
+#if defined( __SSSE3__ )
+    for ( ; x + 16 <= input->width; x += 16 )
+    {
+      __m128i g = lireGris16( in + x * canaux, canaux );
+      if ( out != NULL )
+      {
+        // nombre de seuils <= g, puis le gris de cette classe
+        __m128i classe = _mm_setzero_si128();
+        for ( int k = 0; k < s->nb; ++k )
+          classe = _mm_sub_epi8( classe, _mm_cmpeq_epi8( _mm_max_epu8( g, seuils[ k ] ), g ) );
+        ecrireGris16( out + x * canaux, _mm_shuffle_epi8( niveaux, classe ), canaux );
+      }
+      if ( histo != NULL )
+      {
+        unsigned char gris[ 16 ];
+        _mm_storeu_si128( (__m128i*) gris, g );
+        for ( int j = 0; j < 16; ++j )
+          histo[ j & 3 ][ gris[ j ] ]++;
+      }
+    }
+#endif
+    for ( ; x < input->width; ++x )
+    {
+      unsigned char g = greyLevel( PIXEL_LIGNE( in, x, canaux ) );
+      if ( out != NULL ) setGreyLevel( PIXEL_LIGNE( out, x, canaux ), s->table[ g ] );
+      if ( histo != NULL ) histo[ x & 3 ][ g ]++;
+    }
+  }
+}
+
+static void seuillerHistogramme( const Image* input, Image* output, const Seuils* s,
+                                 uint32_t* histogramme )
+{
+  uint32_t ( *histo )[ 256 ] = NULL;
+  if ( histogramme != NULL )
+    histo = (uint32_t (*)[ 256 ]) calloc( 4, sizeof( *histo ) );
+  SELON_CANAUX( input, seuillerPixels( input, output, s, histo, canaux ) );
+  if ( histo != NULL )
+  {
+    for ( int g = 0; g < 256; ++g )
+      histogramme[ g ] = histo[ 0 ][ g ] + histo[ 1 ][ g ] + histo[ 2 ][ g ] + histo[ 3 ][ g ];
+    free( histo );
+  }
+}
+
+/**
+   Seuille \a input dans \a output (de même format) avec les \a nb_seuils
+   seuils donnés (1 <= nb_seuils < CLASSES_MAX, voir seuillage.h). Si
+   \a histogramme n'est pas NULL, ses 256 cases reçoivent le nombre de
+   pixels de chaque gris de \a input, calculé pendant le même passage.
+*/
+void seuillerNiveaux( const Image* input, Image* output, const int* seuils, int nb_seuils,
+                      uint32_t* histogramme )
+{
+  Seuils s;
+  preparerSeuils( &s, seuils, nb_seuils );
+  seuillerHistogramme( input, output, &s, histogramme );
+}
+
+/**
+   Les 256 cases de \a histogramme reçoivent le nombre de pixels de
+   chaque gris de \a input.
+*/
+void histogrammeImage( const Image* input, uint32_t* histogramme )
+{
+  Seuils s = { 0 };
+  seuillerHistogramme( input, NULL, &s, histogramme );
+}
+
+/**
+   Choisit les nb_classes - 1 seuils (rangés par ordre croissant dans
+   \a seuils, entre 1 et 255) qui maximisent la variance entre les
+   classes de \a histogramme, et en rend le nombre. Cela revient à
+   maximiser la somme, sur les classes, de S² / P, où P est le nombre de
+   pixels de la classe et S la somme de leurs gris. Comme cette somme
+   se fait classe par classe, la meilleure découpe des gris [ 0, b [ en
+   j + 1 classes prolonge la meilleure découpe de [ 0, a [ en j classes:
+   O( nb_classes * 256² ).
+*/
+int seuilsOtsu( const uint32_t* histogramme, int nb_classes, int* seuils )
+{
+  if ( nb_classes < 2 ) nb_classes = 2;
+  if ( nb_classes > CLASSES_MAX ) nb_classes = CLASSES_MAX;
+  // P[ b ], S[ b ]: pixels et somme des gris de [ 0, b [
+  double P[ 257 ], S[ 257 ];
+  P[ 0 ] = S[ 0 ] = 0.0;
+  for ( int g = 0; g < 256; ++g )
+  {
+    P[ g + 1 ] = P[ g ] + histogramme[ g ];
+    S[ g + 1 ] = S[ g ] + (double) g * histogramme[ g ];
+  }
+  // meilleur[ j ][ b ]: meilleure somme pour [ 0, b [ en j + 1 classes,
+  // dont la dernière commence en debut[ j ][ b ]
+  double ( *meilleur )[ 257 ] = (double (*)[ 257 ]) malloc( nb_classes * sizeof( *meilleur ) );
+  int ( *debut )[ 257 ] = (int (*)[ 257 ]) malloc( nb_classes * sizeof( *debut ) );
+#define SCORE( a, b ) ( P[ b ] > P[ a ] ? ( S[ b ] - S[ a ] ) * ( S[ b ] - S[ a ] ) / ( P[ b ] - P[ a ] ) : 0.0 )
+  for ( int b = 1; b <= 256; ++b )
+    meilleur[ 0 ][ b ] = SCORE( 0, b );
+  for ( int j = 1; j < nb_classes; ++j )
+    for ( int b = j + 1; b <= 256; ++b )
+    {
+      meilleur[ j ][ b ] = -1.0;
+      for ( int a = j; a < b; ++a )
+      {
+        double v = meilleur[ j - 1 ][ a ] + SCORE( a, b );
+        if ( v > meilleur[ j ][ b ] )
+        {
+          meilleur[ j ][ b ] = v;
+          debut[ j ][ b ] = a;
+        }
+      }
+    }
+#undef SCORE
+  int b = 256;
+  for ( int j = nb_classes - 1; j >= 1; --j )
+  {
+    b = debut[ j ][ b ];
+    seuils[ j - 1 ] = b;
+  }
+  free( debut );
+  free( meilleur );
+  return nb_classes - 1;
+}
+
+/**
+   Seuillage automatique: histogramme de \a input, seuils d'Otsu en
+   \a nb_classes classes (rendus dans \a seuils, CLASSES_MAX - 1 cases),
+   puis seuillage de \a input dans \a output. Rend le nombre de seuils.
+*/
+int seuillerAutomatique( const Image* input, Image* output, int nb_classes, int* seuils )
+{
+  uint32_t histogramme[ 256 ];
+  histogrammeImage( input, histogramme );
+  int nb = seuilsOtsu( histogramme, nb_classes, seuils );
+  seuillerNiveaux( input, output, seuils, nb, NULL );
+  return nb;
+}
+
+/**
+   Nom du jeu d'instructions utilisé par seuillerNiveaux.
+*/
+const char* jeuInstructionsSeuillage( void )
+{
+#if defined( __SSSE3__ )
+  return "ssse3";
+#else
+  return "scalaire";
+#endif
+}
@@ -0,0 +1,39 @@
+#ifndef SEUILLAGE_H
+#define SEUILLAGE_H
+
+/**
+   Seuillage vectorisé, histogramme des gris et seuils automatiques.
+
+   seuiller() appelait greyLevel (une division par 3) et setGreyLevel
+   pixel par pixel. Ici, en SSSE3, on traite 16 pixels à la fois: on
+   les désentrelace en mots de 16 bits r + v + b, le gris est
+   ( r + v + b ) * 0xaaab >> 17, exactement la division entière par 3
+   pour r + v + b <= 765, puis on compare aux seuils et on réécrit les
+   16 pixels par des écritures de 16 octets. L'histogramme des gris
+   est rempli pendant le même passage. Sans SSSE3, la version scalaire
+   donne les mêmes pixels.
+
+   Les seuils s_1 < ... < s_n découpent les gris en n + 1 classes: le
+   gris g est dans la classe j si exactement j seuils sont <= g, et
+   devient j * 255 / n. Avec un seul seuil, c'est seuiller(): noir en
+   dessous, blanc sinon.
+
+   seuilsOtsu choisit les n seuils qui maximisent la variance entre
+   classes de l'histogramme (Otsu, 1979); avec plusieurs seuils, par
+   programmation dynamique sur les 256 gris.
+*/
+
+#include <stdint.h>
+#include "segmentation.h"
+
+/// Nombre maximal de classes (un octet de table par classe, en SSSE3).
+#define CLASSES_MAX 16
+
+void seuillerNiveaux( const Image* input, Image* output, const int* seuils, int nb_seuils,
+                      uint32_t* histogramme );
+void histogrammeImage( const Image* input, uint32_t* histogramme );
+int seuilsOtsu( const uint32_t* histogramme, int nb_classes, int* seuils );
+int seuillerAutomatique( const Image* input, Image* output, int nb_classes, int* seuils );
+const char* jeuInstructionsSeuillage( void );
+
+#endif
@@ -0,0 +1,223 @@
+#include <stdlib.h>
+#include <string.h>
+#include "tampons.h"
+
+/// Étiquette pas encore attribuée.
+#define SANS_ETIQUETTE UINT32_MAX
+
+Tampons* creerTampons( void )
+{
+  return (Tampons*) calloc( 1, sizeof( Tampons ) );
+}
+
+/**
+   Prépare \a tampons pour une image de \a taille pixels et rend sa
+   forêt, remise à des singletons. On ne réalloue que si \a taille
+   dépasse la capacité.
+*/
+Foret* preparerTampons( Tampons* tampons, uint32_t taille )
+{
+  if ( taille > tampons->capacite )
+  {
+    free( tampons->foret.pere );
+    free( tampons->foret.rang );
+    free( tampons->etiquettes );
+    free( tampons->sommes );
+    free( tampons->couleurs );
+    tampons->foret.pere = (uint32_t*) malloc( taille * sizeof( uint32_t ) );
+    tampons->foret.rang = (uint8_t*) malloc( taille * sizeof( uint8_t ) );
+    tampons->etiquettes = (uint32_t*) malloc( taille * sizeof( uint32_t ) );
+    tampons->sommes     = (SommeCouleur*) malloc( taille * sizeof( SommeCouleur ) );
+    tampons->couleurs   = (Pixel*) malloc( taille * sizeof( Pixel ) );
+    tampons->capacite = taille;
+  }
+  tampons->foret.taille = taille;
+  reinitialiserForet( &tampons->foret );
+  return &tampons->foret;
+}
+
+void libererTampons( Tampons* tampons )
+{
+  if ( tampons == NULL ) return;
+  free( tampons->foret.pere );
+  free( tampons->foret.rang );
+  free( tampons->etiquettes );
+  free( tampons->sommes );
+  free( tampons->couleurs );
+  free( tampons );
+}
+
+/**
+   Fait appeler \a avancement au début de chaque phase des calculs qui
+   utilisent \a tampons (NULL pour ne plus suivre).
+*/
+void suivreTampons( Tampons* tampons, FonctionAvancement avancement, void* data )
+{
+  tampons->avancement = avancement;
+  tampons->donnees_avancement = data;
+}
+
+/**
+   Annonce le début de \a phase. Rend FALSE si le calcul doit s'arrêter.
+   Avec l'instrumentation, chronomètre les phases et analyse la forêt à
+   la fin des unions.
+*/
+bool annoncerPhase( Tampons* tampons, PhaseSegmentation phase )
+{
+  INSTRUMENTER(
+    if ( phase == AVANCEMENT_STATS )
+      instrumentationPhase( phase, tampons->foret.pere, tampons->foret.rang, tampons->foret.taille );
+    else
+      instrumentationPhase( phase, NULL, NULL, 0 );
+    if ( phase == AVANCEMENT_FINI )
+      instrumentationFusionner();
+  )
+  return tampons->avancement == NULL || tampons->avancement( phase, tampons->donnees_avancement );
+}
+
+/**
+   Fait remplir \a table (composantes.h) par les calculs qui utilisent
+   \a tampons, pendant le parcours qui somme les couleurs (NULL pour
+   arrêter).
+*/
+void mesurerTampons( Tampons* tampons, TableComposantes* table )
+{
+  tampons->table = table;
+}
+
+/// Ajoute la couleur de \a pixel à la composante \a e.
+static inline void sommer( SommeCouleur* sommes, uint32_t e, const Pixel* pixel )
+{
+  sommes[ e ].rouge += pixel->rouge;
+  sommes[ e ].vert  += pixel->vert;
+  sommes[ e ].bleu  += pixel->bleu;
+  sommes[ e ].nb += 1;
+}
+
+/// sommerComposantes pour des pixels de \a canaux octets.
+static inline uint32_t sommerPixels( const Image* input, Tampons* tampons, const int canaux )
+{
+  Foret* foret = &tampons->foret;
+  uint32_t* etiquettes = tampons->etiquettes;
+  SommeCouleur* sommes = tampons->sommes;
+  TableComposantes* table = tampons->table;
+  memset( etiquettes, 0xff, foret->taille * sizeof( uint32_t ) );
+  if ( table != NULL ) commencerTable( table, input->width, input->height );
+  uint32_t nb = 0;
+  uint32_t i = 0;
+  for ( int y = 0; y < input->height; ++y )
+  {
+    Pixel* ligne = pixelImage( input, 0, y );
+    for ( int x = 0; x < input->width; ++x, ++i )
+    {
+      uint32_t r = foretTrouver( foret, i );
+      if ( etiquettes[ r ] == SANS_ETIQUETTE )
+      {
+        etiquettes[ r ] = nb;
+        memset( &sommes[ nb ], 0, sizeof( SommeCouleur ) );
+        if ( table != NULL ) ajouterComposante( table, x, y );
+        nb++;
+      }
+      etiquettes[ i ] = etiquettes[ r ];
+      sommer( sommes, etiquettes[ i ], PIXEL_LIGNE( ligne, x, canaux ) );
+      if ( table != NULL ) mesurerPixel( table, etiquettes, etiquettes[ i ], x, y, i );
+    }
+  }
+  return nb;
+}
+
+/**
+   Étapes 4 à 6 fusionnées: une recherche par pixel dans la forêt, qui
+   donne l'étiquette compacte de sa composante (la première rencontrée
+   prend 0, etc.), et somme des couleurs de \a input. L'étiquette d'une
+   composante est rangée dans la case de sa racine jusqu'à ce que le
+   parcours y arrive. Rend le nombre de composantes.
+*/
+uint32_t sommerComposantes( const Image* input, Tampons* tampons )
+{
+  uint32_t nb;
+  SELON_CANAUX( input, nb = sommerPixels( input, tampons, canaux ) );
+  return nb;
+}
+
+/// sommerEtiquettes pour des pixels de \a canaux octets.
+static inline uint32_t sommerEtiquettesPixels( const Image* input, Tampons* tampons, const int canaux )
+{
+  const uint32_t* pere = tampons->foret.pere;
+  uint32_t* etiquettes = tampons->etiquettes;
+  SommeCouleur* sommes = tampons->sommes;
+  TableComposantes* table = tampons->table;
+  if ( table != NULL ) commencerTable( table, input->width, input->height );
+  uint32_t nb = 0;
+  uint32_t i = 0;
+  for ( int y = 0; y < input->height; ++y )
+  {
+    Pixel* ligne = pixelImage( input, 0, y );
+    for ( int x = 0; x < input->width; ++x, ++i )
+    {
+      uint32_t r = pere[ i ] == i ? i : etiquettes[ i ];
+      if ( r >= i && etiquettes[ r ] == r )
+      {
+        etiquettes[ r ] = nb;
+        memset( &sommes[ nb ], 0, sizeof( SommeCouleur ) );
+        if ( table != NULL ) ajouterComposante( table, x, y );
+        nb++;
+      }
+      etiquettes[ i ] = etiquettes[ r ];
+      sommer( sommes, etiquettes[ i ], PIXEL_LIGNE( ligne, x, canaux ) );
+      if ( table != NULL ) mesurerPixel( table, etiquettes, etiquettes[ i ], x, y, i );
+    }
+  }
+  return nb;
+}
+
+/**
+   Comme sommerComposantes, quand \a tampons->etiquettes contient déjà
+   la racine de chaque pixel (calcul multi-threads). Les étiquettes
+   sont compactées sur place. Seules les cases des racines servent à
+   ranger l'étiquette de leur composante: tant qu'elle n'en a pas, la
+   case de la racine r contient encore r, car une étiquette attribuée
+   au pixel j vaut au plus j et r n'est pas encore parcourue.
+*/
+uint32_t sommerEtiquettes( const Image* input, Tampons* tampons )
+{
+  uint32_t nb;
+  SELON_CANAUX( input, nb = sommerEtiquettesPixels( input, tampons, canaux ) );
+  return nb;
+}
+
+/**
+   Étape 7: couleur moyenne (tronquée) de chacune des \a nb composantes.
+*/
+void moyennerComposantes( Tampons* tampons, uint32_t nb )
+{
+  for ( uint32_t e = 0; e < nb; ++e )
+  {
+    const SommeCouleur* s = &tampons->sommes[ e ];
+    tampons->couleurs[ e ].rouge = s->rouge / s->nb;
+    tampons->couleurs[ e ].vert  = s->vert  / s->nb;
+    tampons->couleurs[ e ].bleu  = s->bleu  / s->nb;
+  }
+}
+
+/// peindreComposantes pour des pixels de \a canaux octets.
+static inline void peindrePixels( Image* output, const Tampons* tampons, int y0, int y1, const int canaux )
+{
+  int width = output->width;
+  for ( int y = y0; y < y1; ++y )
+  {
+    Pixel* ligne = pixelImage( output, 0, y );
+    const uint32_t* e = tampons->etiquettes + (uint32_t) y * width;
+    for ( int x = 0; x < width; ++x )
+      *PIXEL_LIGNE( ligne, x, canaux ) = tampons->couleurs[ e[ x ] ];
+  }
+}
+
+/**
+   Étape 8 sur les lignes [ \a y0, \a y1 [: chaque pixel prend la
+   couleur de son étiquette (l'alpha d'un pixel RGBA ne change pas).
+*/
+void peindreComposantes( Image* output, const Tampons* tampons, int y0, int y1 )
+{
+  SELON_CANAUX( output, peindrePixels( output, tampons, y0, y1, canaux ) );
+}
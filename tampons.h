@@ -0,0 +1,68 @@
+#ifndef TAMPONS_H
+#define TAMPONS_H
+
+/**
+   Tampons réutilisables des composantes connexes.
+
+   Une segmentation demande une forêt, une étiquette par pixel, une
+   somme de couleurs et une couleur par composante. Plutôt que de les
+   allouer à chaque clic, l'appelant garde un Tampons d'un calcul à
+   l'autre: ils ne sont réalloués que si l'image grandit.
+
+   Le coloriage (étapes 4 à 8) est fusionné: un seul parcours remonte
+   chaque pixel à sa racine, lui donne une étiquette compacte 0 .. nb-1
+   et somme les couleurs en entiers; un second parcours écrit la
+   couleur moyenne de chaque pixel.
+*/
+
+#include <stdint.h>
+#include "segmentation.h"
+#include "composantes.h"
+
+/// Sommes entières des couleurs d'une composante.
+typedef struct {
+  uint64_t rouge;
+  uint64_t vert;
+  uint64_t bleu;
+  uint32_t nb;
+} SommeCouleur;
+
+/// Phases d'un calcul de composantes, annoncées à FonctionAvancement.
+typedef enum {
+  AVANCEMENT_EMPREINTE, // empreinte et recherche dans le cache (cache.h)
+  AVANCEMENT_UNIONS,  // étapes 1 à 3
+  AVANCEMENT_STATS,   // étapes 4 à 6
+  AVANCEMENT_REPEINT, // étapes 7 et 8
+  AVANCEMENT_FINI
+} PhaseSegmentation;
+
+/**
+   Appelée au début de chaque phase (depuis le thread du calcul). Rend
+   FALSE pour interrompre le calcul: la sortie n'est alors pas touchée.
+*/
+typedef bool (*FonctionAvancement)( PhaseSegmentation phase, void* data );
+
+typedef struct Tampons {
+  uint32_t capacite;     // nombre de pixels alloués
+  Foret foret;           // foret.taille: nombre de pixels de l'image courante
+  uint32_t* etiquettes;  // étiquette compacte de chaque pixel
+  SommeCouleur* sommes;  // par étiquette
+  Pixel* couleurs;       // couleur moyenne par étiquette
+  FonctionAvancement avancement; // NULL: pas de suivi
+  void* donnees_avancement;
+  TableComposantes* table; // NULL: pas de table des composantes
+} Tampons;
+
+Tampons* creerTampons( void );
+Foret* preparerTampons( Tampons* tampons, uint32_t taille );
+void libererTampons( Tampons* tampons );
+void suivreTampons( Tampons* tampons, FonctionAvancement avancement, void* data );
+bool annoncerPhase( Tampons* tampons, PhaseSegmentation phase );
+void mesurerTampons( Tampons* tampons, TableComposantes* table );
+
+uint32_t sommerComposantes( const Image* input, Tampons* tampons );
+uint32_t sommerEtiquettes( const Image* input, Tampons* tampons );
+void moyennerComposantes( Tampons* tampons, uint32_t nb );
+void peindreComposantes( Image* output, const Tampons* tampons, int y0, int y1 );
+
+#endif
@@ -0,0 +1,466 @@
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "segmentation.h"
+#include "image-pixbuf.h"
+#include "plans-tsv.h"
+#include "arbre-alpha.h"
+#include "adaptatif.h"
+#include "seuillage.h"
+#include "tampons.h"
+#include "regions.h"
+#include "gris.h"
+#include "pnm.h"
+#include "cache.h"
+
+/**
+   Mode batch (sans affichage ni serveur X) de la segmentation.
+
+   Les opérations sont appliquées dans l'ordre de la ligne de commande,
+   exactement comme les clics sur les boutons de l'IHM: l'image de
+   sortie part d'une copie de l'entrée, --threshold et --components
+   modifient la sortie courante, --fuzzy repart de l'entrée.
+
+   --threshold auto choisit le seuil d'Otsu (seuillage.h) sur
+   l'histogramme de l'entrée; --levels 4 découpe les gris en 4 classes
+   par les seuils d'Otsu, peintes du noir au blanc.
+
+   --fuzzy-levels 10,20,40 calcule une seule fois l'arbre alpha
+   (arbre-alpha.h) et écrit une image par seuil: out-10.png, out-20.png,
+   out-40.png. La sortie courante est ensuite celle du dernier seuil.
+
+   --adaptive 800 calcule les composantes floues adaptatives
+   (adaptatif.h) de l'entrée: le seuil de chaque fusion dépend de la
+   taille et de la variation interne des composantes, réglées par k.
+
+   --merge 50 fusionne ensuite les régions voisines du dernier
+   --components ou --fuzzy (regions.h) tant que le coût de la fusion
+   reste sous 50; --merge-regions 200 fusionne jusqu'à 200 régions.
+   Les deux peuvent se suivre: une fusion repart de la précédente.
+
+   --table comp.csv (ou comp.bin) écrit à la fin la table des
+   composantes (composantes.h) du dernier --components ou --fuzzy, sans
+   les composantes de moins de --min-area pixels. --fuzzy-levels ne
+   remplit pas la table.
+
+   Si l'entrée et la sortie sont toutes deux des PGM (ou des PPM)
+   binaires, on ne passe pas par gdk-pixbuf: les deux fichiers sont
+   projetés en mémoire (pnm.h) et la segmentation lit et écrit
+   directement leurs pixels. Un PGM reste à un octet par pixel, ou à
+   deux s'il est en 16 bits (gris.h).
+
+   --cache resultats/ garde les résultats de --components, --fuzzy et
+   --adaptive (cache.h) dans le dossier resultats/: la même image,
+   segmentée avec les mêmes réglages par un appel suivant, est
+   seulement repeinte. --cache - les garde en mémoire, pour cet appel
+   seulement. Ne concerne que les images RGB, et les opérations qui le
+   suivent.
+
+   Les PNG avec alpha sont segmentés en RGBA, sans conversion: l'alpha
+   de la sortie est celui de l'entrée.
+
+   prompt$ ./union-find-batch --threshold 128 --components lena.png out.png
+*/
+
+//-----------------------------------------------------------------------------
+// Déclaration des types
+//-----------------------------------------------------------------------------
+/**
+   Les images de travail: des GdkPixbuf, ou des fichiers PGM/PPM
+   projetés en mémoire.
+*/
+typedef struct {
+  GdkPixbuf* pixbuf_input;  // NULL si les fichiers sont projetés
+  GdkPixbuf* pixbuf_output;
+  ImagePNM pnm_input;
+  ImagePNM pnm_output;
+  bool gris;                // PGM projeté: on travaille sur gris_input/gris_output
+  Image input;
+  Image output;
+  ImageGrise gris_input;
+  ImageGrise gris_output;
+  Tampons* tampons;
+} Images;
+
+//-----------------------------------------------------------------------------
+// Déclaration des fonctions
+//-----------------------------------------------------------------------------
+void usage( const char* prog );
+const char* formatDepuisNom( const char* filename );
+bool ouvrirImages( Images* im, const char* input_filename, const char* output_filename );
+bool enregistrerSortie( Images* im, const char* filename, const char* output_filename );
+void fermerImages( Images* im );
+int ecrireNiveauxFlous( Images* im, const char* niveaux, const char* output_filename );
+void seuillerOtsu( Images* im, int nb_classes );
+
+//-----------------------------------------------------------------------------
+// Programme principal
+//-----------------------------------------------------------------------------
+int main( int   argc,
+          char* argv[] )
+{
+  if ( argc < 3 )
+  {
+    usage( argv[ 0 ] );
+    return 1;
+  }
+  const char* input_filename  = argv[ argc - 2 ];
+  const char* output_filename = argv[ argc - 1 ];
+  Images im;
+  if ( ! ouvrirImages( &im, input_filename, output_filename ) )
+    return 1;
+
+  // Applique les opérations dans l'ordre donné.
+  const char* instrumentation = NULL;
+  const char* table_filename = NULL;
+  TableComposantes* table = NULL;
+  uint32_t aire_min = 0;
+  bool etiquettes = FALSE; // les tampons décrivent les composantes de la sortie
+  bool par_plages = FALSE;
+  Cache* cache = NULL;
+  int ok = TRUE;
+  for ( int i = 1; i < argc - 2 && ok; ++i )
+  {
+    if ( strcmp( argv[ i ], "--threshold" ) == 0 && i + 1 < argc - 2 )
+    {
+      const char* valeur = argv[ ++i ];
+      if ( strcmp( valeur, "auto" ) == 0 ) seuillerOtsu( &im, 2 );
+      else if ( im.gris ) seuillerGris( &im.gris_input, &im.gris_output, atoi( valeur ) );
+      else                seuiller( &im.input, &im.output, atoi( valeur ) );
+      etiquettes = FALSE;
+    }
+    else if ( strcmp( argv[ i ], "--levels" ) == 0 && i + 1 < argc - 2
+              && atoi( argv[ i + 1 ] ) >= 2 && atoi( argv[ i + 1 ] ) <= CLASSES_MAX )
+    {
+      seuillerOtsu( &im, atoi( argv[ ++i ] ) );
+      etiquettes = FALSE;
+    }
+    else if ( strcmp( argv[ i ], "--components" ) == 0 )
+    {
+      if ( im.gris ) calculerComposantesConnexesGris( &im.gris_input, &im.gris_output, im.tampons );
+      else           calculerComposantesConnexesCache( cache, &im.input, &im.output, im.tampons );
+      etiquettes = ! im.gris && ( ! par_plages || table != NULL );
+    }
+    else if ( strcmp( argv[ i ], "--fuzzy" ) == 0 && i + 1 < argc - 2 )
+    {
+      double floue = atof( argv[ ++i ] );
+      if ( im.gris ) calculerComposantesConnexesFlouesGris( &im.gris_input, &im.gris_output, floue, im.tampons );
+      else
+      {
+        PlansTSV* plans = NULL;
+        calculerComposantesConnexesFlouesCache( cache, &im.input, &im.output, &plans, floue, im.tampons,
+                                                NULL, NULL );
+        libererPlansTSV( plans );
+      }
+      etiquettes = ! im.gris;
+    }
+    else if ( strcmp( argv[ i ], "--adaptive" ) == 0 && i + 1 < argc - 2 )
+    {
+      double k = atof( argv[ ++i ] );
+      if ( im.gris )
+      {
+        fprintf( stderr, "--adaptive: image RGB attendue\n" );
+        ok = FALSE;
+      }
+      else
+      {
+        PlansTSV* plans = NULL;
+        calculerComposantesAdaptativesCache( cache, &im.input, &im.output, &plans, k, im.tampons );
+        libererPlansTSV( plans );
+      }
+      etiquettes = ! im.gris;
+    }
+    else if ( ( strcmp( argv[ i ], "--merge" ) == 0 || strcmp( argv[ i ], "--merge-regions" ) == 0 )
+              && i + 1 < argc - 2 )
+    {
+      bool nombre = strcmp( argv[ i ], "--merge-regions" ) == 0;
+      const char* valeur = argv[ ++i ];
+      if ( ! etiquettes )
+      {
+        fprintf( stderr, "%s: il faut d'abord --components, --fuzzy ou --adaptive sur une image RGB\n", argv[ i - 1 ] );
+        ok = FALSE;
+      }
+      else if ( nombre )
+        fusionnerRegions( &im.output, im.tampons, TOLERANCE_INFINIE, (uint32_t) atoi( valeur ) );
+      else
+        fusionnerRegions( &im.output, im.tampons, atof( valeur ), 0 );
+    }
+    else if ( strcmp( argv[ i ], "--fuzzy-levels" ) == 0 && i + 1 < argc - 2 )
+    {
+      ok = ecrireNiveauxFlous( &im, argv[ ++i ], output_filename );
+      etiquettes = FALSE;
+    }
+    else if ( strcmp( argv[ i ], "--runs" ) == 0 )
+    {
+      choisirMoteurComposantes( COMPOSANTES_PAR_PLAGES );
+      par_plages = TRUE;
+    }
+    else if ( strcmp( argv[ i ], "--connectivity" ) == 0 && i + 1 < argc - 2
+              && ( atoi( argv[ i + 1 ] ) == 4 || atoi( argv[ i + 1 ] ) == 8 ) )
+      choisirConnexite( atoi( argv[ ++i ] ) == 8 ? CONNEXITE_8 : CONNEXITE_4 );
+    else if ( strcmp( argv[ i ], "--instrumentation" ) == 0 && i + 1 < argc - 2 )
+      instrumentation = argv[ ++i ];
+    else if ( strcmp( argv[ i ], "--table" ) == 0 && i + 1 < argc - 2 )
+    {
+      table_filename = argv[ ++i ];
+      if ( table == NULL ) table = creerTable();
+      mesurerTampons( im.tampons, table );
+    }
+    else if ( strcmp( argv[ i ], "--min-area" ) == 0 && i + 1 < argc - 2 )
+      aire_min = (uint32_t) atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--cache" ) == 0 && i + 1 < argc - 2 )
+    {
+      const char* dossier = argv[ ++i ];
+      libererCache( cache );
+      cache = creerCache( CAPACITE_CACHE_DEFAUT, strcmp( dossier, "-" ) == 0 ? NULL : dossier );
+    }
+    else if ( strcmp( argv[ i ], "--threads" ) == 0 && i + 1 < argc - 2 )
+      choisirNombreThreads( atoi( argv[ ++i ] ) );
+    else if ( strcmp( argv[ i ], "--lock-free" ) == 0 )
+      choisirUnionsConcurrentes( TRUE );
+    else if ( strcmp( argv[ i ], "--find" ) == 0 && i + 1 < argc - 2
+              && methodeTrouverDepuisNom( argv[ i + 1 ] ) >= 0 )
+      choisirMethodeTrouver( methodeTrouverDepuisNom( argv[ ++i ] ) );
+    else
+    {
+      usage( argv[ 0 ] );
+      ok = FALSE;
+    }
+  }
+
+  ok = ok && enregistrerSortie( &im, output_filename, output_filename );
+  fermerImages( &im );
+  libererCache( cache );
+  if ( ok && table != NULL )
+  {
+    if ( aire_min > 0 ) filtrerComposantes( table, aire_min );
+    if ( ! ecrireTable( table, table_filename ) ) { perror( table_filename ); ok = FALSE; }
+  }
+  libererTable( table );
+  if ( ok && instrumentation != NULL )
+  {
+    FILE* f = fopen( instrumentation, "w" );
+    if ( f != NULL ) { ecrireInstrumentationJSON( f ); fclose( f ); }
+    else { perror( instrumentation ); ok = FALSE; }
+  }
+  return ok ? 0 : 1;
+}
+
+void usage( const char* prog )
+{
+  fprintf( stderr,
+           "usage: %s [--threads <n>] [--lock-free] [--runs] [--connectivity 4|8] [--find <methode>] [--threshold <seuil|auto>] [--levels <n>] [--components] [--fuzzy <floue>]"
+           " [--adaptive <k>] [--fuzzy-levels <f1,f2,...>] [--instrumentation <json>] [--merge <tolerance>] [--merge-regions <n>] [--table <csv|bin>] [--min-area <n>]"
+           " [--cache <dossier|->] <entree> <sortie>\n"
+           "  les operations sont appliquees dans l'ordre donne\n"
+           "  --lock-free: avec --threads, unions sans verrou sur une foret partagee\n"
+           "  --runs: composantes par plages plutot que pixel par pixel\n"
+           "  --connectivity: 4 voisins (defaut) ou 8 avec les diagonales\n"
+           "  --threshold auto: seuil d'Otsu, choisi sur l'histogramme des gris\n"
+           "  --levels: <n> classes de gris (2 a 16) separees par les seuils d'Otsu\n"
+           "  --adaptive: composantes floues dont le seuil s'adapte a chaque composante:\n"
+           "  poids interne maximal + k / taille (k grand: moins de composantes)\n"
+           "  --fuzzy-levels: une sortie <sortie>-<floue>.<ext> par seuil, en une passe\n"
+           "  --instrumentation: compteurs de l'union-find et durees des phases en JSON\n"
+           "  (binaire compile avec INSTRUMENTATION=-DINSTRUMENTATION)\n"
+           "  --merge: fusionne les regions voisines du dernier calcul (RGB) tant que\n"
+           "  similitude des moyennes x na nb / (na + nb) <= tolerance\n"
+           "  --merge-regions: fusionne jusqu'a ne garder que <n> regions\n"
+           "  --table: aire, boite, centre, couleur moyenne et perimetre de chaque composante\n"
+           "  du dernier calcul, en CSV (ou en binaire si le fichier finit par .bin)\n"
+           "  --min-area: sans les composantes de moins de <n> pixels\n"
+           "  --cache: garde les resultats des operations suivantes (RGB) dans <dossier>,\n"
+           "  ou en memoire seulement avec -, et les reprend pour la meme image et les memes reglages\n"
+           "  entree et sortie .pgm (ou .ppm): fichiers projetes en memoire, sans gdk-pixbuf\n"
+           "  (PGM 16 bits: seuil et floue restent sur l'echelle 0..255)\n"
+           "  methodes de recherche: recursif, deux-passes (defaut), demi-chemin, scission\n", prog );
+}
+
+/**
+   Déduit le format gdk-pixbuf ("png", "jpeg", ...) de l'extension du fichier.
+*/
+const char* formatDepuisNom( const char* filename )
+{
+  const char* ext = strrchr( filename, '.' );
+  if ( ext == NULL ) return "png";
+  ++ext;
+  if ( strcasecmp( ext, "jpg" ) == 0 || strcasecmp( ext, "jpeg" ) == 0 ) return "jpeg";
+  if ( strcasecmp( ext, "bmp" ) == 0 ) return "bmp";
+  if ( strcasecmp( ext, "tif" ) == 0 || strcasecmp( ext, "tiff" ) == 0 ) return "tiff";
+  return "png";
+}
+
+/**
+   Ouvre l'entrée et prépare une sortie qui en est la copie. Les
+   PGM/PPM dont la sortie porte la même extension sont projetés en
+   mémoire; le reste passe par gdk-pixbuf (qui convertit un PGM en RGB).
+*/
+bool ouvrirImages( Images* im, const char* input_filename, const char* output_filename )
+{
+  memset( im, 0, sizeof( Images ) );
+  const char* ext_input  = strrchr( input_filename, '.' );
+  const char* ext_output = strrchr( output_filename, '.' );
+  if ( estNomPNM( input_filename ) && estNomPNM( output_filename )
+       && strcasecmp( ext_input, ext_output ) == 0 )
+  {
+    bool ok = projeterPNM( input_filename, &im->pnm_input );
+    if ( ! ok && errno == EFBIG )
+    {
+      fprintf( stderr, "%s: image trop grande (au plus %d lignes et %u pixels)\n",
+               input_filename, INT_MAX, (unsigned) UINT32_MAX );
+      return FALSE;
+    }
+    // la similitude et les couleurs moyennes sont sur 8 bits: pas de PPM 16 bits
+    if ( ok && im->pnm_input.entete.canaux == 3 && im->pnm_input.entete.octets == 2 )
+    {
+      fermerPNM( &im->pnm_input );
+      ok = FALSE;
+    }
+    if ( ! ok )
+    {
+      fprintf( stderr, "%s: PGM (P5) 8 ou 16 bits, ou PPM (P6) 8 bits attendu\n", input_filename );
+      return FALSE;
+    }
+    const EntetePNM* e = &im->pnm_input.entete;
+    if ( ! creerPNM( output_filename, e, &im->pnm_output ) )
+    {
+      perror( output_filename );
+      fermerPNM( &im->pnm_input );
+      return FALSE;
+    }
+    memcpy( im->pnm_output.data, im->pnm_input.data, taillePixelsPNM( e ) );
+    im->gris = e->canaux == 1;
+    im->input  = imageDepuisPNM( &im->pnm_input );
+    im->output = imageDepuisPNM( &im->pnm_output );
+    im->gris_input  = imageGriseDepuisPNM( &im->pnm_input );
+    im->gris_output = imageGriseDepuisPNM( &im->pnm_output );
+  }
+  else
+  {
+    GError* error = NULL;
+    im->pixbuf_input = gdk_pixbuf_new_from_file( input_filename, &error );
+    if ( im->pixbuf_input == NULL )
+    {
+      fprintf( stderr, "%s: %s\n", input_filename, error->message );
+      g_error_free( error );
+      return FALSE;
+    }
+    if ( ! pixbufCompatible( im->pixbuf_input ) )
+    {
+      fprintf( stderr, "%s: format non supporte (RGB ou RGBA 8 bits attendu)\n", input_filename );
+      g_object_unref( im->pixbuf_input );
+      return FALSE;
+    }
+    im->pixbuf_output = gdk_pixbuf_copy( im->pixbuf_input );
+    im->input  = imageDepuisPixbuf( im->pixbuf_input );
+    im->output = imageDepuisPixbuf( im->pixbuf_output );
+  }
+  im->tampons = creerTampons();
+  return TRUE;
+}
+
+/**
+   Écrit la sortie courante dans \a filename. Une sortie projetée est
+   déjà dans \a output_filename; pour un autre nom on crée une copie.
+*/
+bool enregistrerSortie( Images* im, const char* filename, const char* output_filename )
+{
+  if ( im->pixbuf_output == NULL )
+  {
+    if ( strcmp( filename, output_filename ) == 0 ) return TRUE;
+    ImagePNM copie;
+    const EntetePNM* e = &im->pnm_output.entete;
+    if ( ! creerPNM( filename, e, &copie ) )
+    {
+      perror( filename );
+      return FALSE;
+    }
+    memcpy( copie.data, im->pnm_output.data, taillePixelsPNM( e ) );
+    fermerPNM( &copie );
+    return TRUE;
+  }
+  GError* error = NULL;
+  if ( ! gdk_pixbuf_save( im->pixbuf_output, filename, formatDepuisNom( filename ), &error, NULL ) )
+  {
+    fprintf( stderr, "%s: %s\n", filename, error->message );
+    g_error_free( error );
+    return FALSE;
+  }
+  return TRUE;
+}
+
+void fermerImages( Images* im )
+{
+  libererTampons( im->tampons );
+  if ( im->pixbuf_output == NULL )
+  {
+    fermerPNM( &im->pnm_output );
+    fermerPNM( &im->pnm_input );
+  }
+  else
+  {
+    g_object_unref( im->pixbuf_output );
+    g_object_unref( im->pixbuf_input );
+  }
+}
+
+/**
+   Écrit, pour chaque seuil de la liste \a niveaux (séparés par des
+   virgules), les composantes floues dans <sortie>-<seuil>.<ext>. En
+   RGB on construit une seule fois l'arbre alpha de l'entrée; un PGM
+   projeté refait les unions à un octet par pixel pour chaque seuil.
+   Rend FALSE en cas d'erreur.
+*/
+int ecrireNiveauxFlous( Images* im, const char* niveaux, const char* output_filename )
+{
+  ArbreAlpha* arbre = NULL;
+  if ( ! im->gris )
+  {
+    PlansTSV* plans = creerPlansTSV( &im->input );
+    arbre = construireArbreAlpha( plans );
+    libererPlansTSV( plans );
+  }
+
+  const char* ext = strrchr( output_filename, '.' );
+  int base = ext != NULL ? (int) ( ext - output_filename ) : (int) strlen( output_filename );
+  if ( ext == NULL ) ext = "";
+  char* nom = (char*) malloc( strlen( output_filename ) + strlen( niveaux ) + 2 );
+  int ok = TRUE;
+  const char* niveau = niveaux;
+  while ( ok && *niveau != '\0' )
+  {
+    int longueur = (int) strcspn( niveau, "," );
+    if ( arbre != NULL )
+      composantesArbreAlpha( arbre, &im->input, &im->output, atof( niveau ) );
+    else
+      calculerComposantesConnexesFlouesGris( &im->gris_input, &im->gris_output, atof( niveau ), im->tampons );
+    sprintf( nom, "%.*s-%.*s%s", base, output_filename, longueur, niveau, ext );
+    ok = enregistrerSortie( im, nom, output_filename );
+    niveau += longueur;
+    if ( *niveau == ',' ) ++niveau;
+  }
+  free( nom );
+  if ( arbre != NULL ) libererArbreAlpha( arbre );
+  return ok;
+}
+
+/**
+   Seuille l'entrée en \a nb_classes classes, avec les seuils d'Otsu de
+   son histogramme des gris (seuillage.h).
+*/
+void seuillerOtsu( Images* im, int nb_classes )
+{
+  int seuils[ CLASSES_MAX - 1 ];
+  if ( im->gris )
+  {
+    uint32_t histogramme[ 256 ];
+    histogrammeGris( &im->gris_input, histogramme );
+    int nb = seuilsOtsu( histogramme, nb_classes, seuils );
+    seuillerGrisNiveaux( &im->gris_input, &im->gris_output, seuils, nb );
+  }
+  else
+    seuillerAutomatique( &im->input, &im->output, nb_classes, seuils );
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "segmentation.h"
+#include "flux.h"
+#include "pnm.h"
+
+/**
+   Composantes connexes en flux d'un PGM/PPM binaire, ligne par ligne
+   (voir flux.h): la mémoire ne dépend que de la largeur de l'image.
+
+   Chaque composante fermée est écrite en CSV dans <sortie> ("-" pour
+   la sortie standard): numéro, gris, nombre de pixels, boîte
+   englobante et couleur moyenne (tronquée, comme les étapes 7 et 8).
+
+   prompt$ ./union-find-flux --threshold 128 scan.pgm composantes.csv
+*/
+
+//-----------------------------------------------------------------------------
+// Déclaration des fonctions
+//-----------------------------------------------------------------------------
+void usage( const char* prog );
+void ecrireComposante( const ComposanteFlux* c, void* data );
+
+//-----------------------------------------------------------------------------
+// Programme principal
+//-----------------------------------------------------------------------------
+int main( int   argc,
+          char* argv[] )
+{
+  int seuil = -1;
+  int i = 1;
+  for ( ; i < argc - 2; ++i )
+  {
+    if ( strcmp( argv[ i ], "--threshold" ) == 0 && i + 1 < argc - 2 )
+      seuil = atoi( argv[ ++i ] );
+    else
+      break;
+  }
+  if ( i != argc - 2 )
+  {
+    usage( argv[ 0 ] );
+    return 1;
+  }
+  const char* input_filename  = argv[ argc - 2 ];
+  const char* output_filename = argv[ argc - 1 ];
+
+  FILE* entree = fopen( input_filename, "rb" );
+  if ( entree == NULL )
+  {
+    perror( input_filename );
+    return 1;
+  }
+  EntetePNM entete;
+  if ( ! lireEntetePNM( entree, &entete ) || entete.octets != 1 )
+  {
+    fprintf( stderr, "%s: PGM (P5) ou PPM (P6) 8 bits attendu\n", input_filename );
+    fclose( entree );
+    return 1;
+  }
+  if ( ! tientEnFluxPNM( &entete ) )
+  {
+    fprintf( stderr, "%s: image trop grande (sommes de couleurs sur 64 bits)\n", input_filename );
+    fclose( entree );
+    return 1;
+  }
+  FILE* sortie = strcmp( output_filename, "-" ) == 0 ? stdout : fopen( output_filename, "w" );
+  if ( sortie == NULL )
+  {
+    perror( output_filename );
+    fclose( entree );
+    return 1;
+  }
+
+  fprintf( sortie, "numero,gris,pixels,x0,y0,x1,y1,rouge,vert,bleu\n" );
+  Pixel* ligne = (Pixel*) malloc( entete.width * sizeof( Pixel ) );
+  Flux* flux = creerFlux( entete.width, seuil, ecrireComposante, sortie );
+  int ok = TRUE;
+  for ( int64_t y = 0; y < entete.height && ok; ++y )
+  {
+    ok = lireLignePNM( entree, &entete, ligne );
+    if ( ok )
+      ajouterLigneFlux( flux, ligne );
+    else
+      fprintf( stderr, "%s: fichier tronque a la ligne %" PRId64 "\n", input_filename, y );
+  }
+  terminerFlux( flux );
+  libererFlux( flux );
+  free( ligne );
+  fclose( entree );
+  if ( sortie != stdout ) fclose( sortie );
+  return ok ? 0 : 1;
+}
+
+void usage( const char* prog )
+{
+  fprintf( stderr,
+           "usage: %s [--threshold <seuil>] <entree.pgm|ppm> <sortie.csv|->\n"
+           "  composantes connexes en flux, ligne par ligne\n", prog );
+}
+
+/**
+   Écrit une composante fermée en CSV dans le FILE* \a data.
+*/
+void ecrireComposante( const ComposanteFlux* c, void* data )
+{
+  fprintf( (FILE*) data, "%" PRIu64 ",%d,%" PRIu64 ",%d,%" PRId64 ",%d,%" PRId64 ",%d,%d,%d\n",
+           c->numero, c->gris, c->nb, c->x0, c->y0, c->x1, c->y1,
+           (int) ( c->rouge / c->nb ), (int) ( c->vert / c->nb ), (int) ( c->bleu / c->nb ) );
+}
@@ -0,0 +1,543 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <strings.h>
+#include <time.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "segmentation.h"
+#include "image-pixbuf.h"
+#include "plans-tsv.h"
+#include "adaptatif.h"
+#include "seuillage.h"
+#include "tampons.h"
+#include "file-bornee.h"
+#include "cache.h"
+
+/**
+   Segmentation d'un lot d'images (des milliers de fichiers, ou des
+   dossiers entiers), en chaîne: des threads de décodage, des threads de
+   segmentation et des threads d'écriture, reliés par des files bornées
+   (file-bornee.h). Le décodage et l'écriture d'une image recouvrent la
+   segmentation des autres, et plusieurs images sont segmentées en même
+   temps.
+
+   Au plus --in-flight images sont en mémoire à la fois: chacune occupe
+   un emplacement (Travail), avec ses pixbufs et ses tampons, qui ne
+   revient aux décodeurs qu'une fois l'image écrite. Les tampons d'un
+   emplacement sont réutilisés d'une image à l'autre.
+
+   Les opérations sont appliquées dans l'ordre donné, comme en mode
+   batch: la sortie part d'une copie de l'entrée, --threshold (ou
+   --levels) et --components modifient la sortie, --fuzzy et --adaptive
+   repartent de l'entrée. --threshold auto choisit le seuil d'Otsu de
+   chaque image.
+   Avec --cache resultats/, les segmentations de tous les threads
+   passent par un même cache (cache.h), gardé dans le dossier
+   resultats/ (ou en mémoire seulement avec --cache -): une image déjà
+   segmentée avec les mêmes réglages, dans ce lot ou un précédent,
+   n'est que repeinte.
+   Chaque image est écrite dans le dossier de sortie (créé au besoin)
+   sous le nom de son entrée, avec l'extension --ext si elle est
+   donnée, ou nulle part avec la sortie "-".
+
+   À la fin, le programme affiche le débit en images par seconde et,
+   pour chaque étage, la part du temps où ses threads ont travaillé
+   (plutôt qu'attendu une image ou une place): l'étage le plus occupé
+   est celui auquel il faut donner des coeurs, puis les compteurs du
+   cache s'il y en a un.
+
+   prompt$ ./union-find-lot --threshold 128 --components photos/ sorties/
+*/
+
+//-----------------------------------------------------------------------------
+// Déclaration des types
+//-----------------------------------------------------------------------------
+typedef enum {
+  OPERATION_SEUIL,
+  OPERATION_NIVEAUX,      // seuils d'Otsu (--threshold auto, --levels)
+  OPERATION_COMPOSANTES,
+  OPERATION_FLOUES,
+  OPERATION_ADAPTATIVES
+} TypeOperation;
+
+typedef struct {
+  TypeOperation type;
+  double valeur;      // seuil, nombre de classes, floue ou k
+} Operation;
+
+/// Une image en cours de traitement: un emplacement parmi --in-flight.
+typedef struct {
+  int numero;         // indice de l'entrée
+  GdkPixbuf* input;
+  GdkPixbuf* output;
+  Tampons* tampons;   // gardés d'une image à l'autre
+} Travail;
+
+/// Un étage de la chaîne et le temps que ses threads ont passé à travailler.
+typedef struct {
+  const char* nom;
+  int nb_threads;
+  int actifs;         // threads pas encore terminés
+  double occupe;      // ms, tous threads confondus
+  int nb_images;
+} Etage;
+
+typedef struct {
+  char** entrees;
+  int nb_entrees;
+  const char* dossier;     // NULL: pas d'écriture
+  const char* extension;   // NULL: celle de l'entrée
+  Operation* operations;
+  int nb_operations;
+  Cache* cache;            // NULL: pas de cache
+  FileBornee* libres;      // emplacements disponibles pour le décodage
+  FileBornee* a_segmenter;
+  FileBornee* a_ecrire;
+  pthread_mutex_t verrou;  // prochain, erreurs et étages
+  int prochain;            // prochaine entrée à décoder
+  int erreurs;
+  Etage decodage;
+  Etage segmentation;
+  Etage ecriture;
+} Lot;
+
+//-----------------------------------------------------------------------------
+// Déclaration des fonctions
+//-----------------------------------------------------------------------------
+void usage( const char* prog );
+double maintenant( void );
+const char* formatDepuisNom( const char* filename );
+void ajouterEntree( Lot* lot, const char* filename );
+bool ajouterEntrees( Lot* lot, const char* chemin );
+char* nomSortie( const Lot* lot, int numero );
+void compterImage( Lot* lot, Etage* etage, double debut, bool erreur );
+void terminerEtage( Lot* lot, Etage* etage, FileBornee* suivante );
+void* decoder( void* arg );
+void* segmenter( void* arg );
+void* ecrire( void* arg );
+void afficherEtage( const Etage* etage, double duree );
+
+//-----------------------------------------------------------------------------
+// Programme principal
+//-----------------------------------------------------------------------------
+int main( int   argc,
+          char* argv[] )
+{
+  Lot lot;
+  memset( &lot, 0, sizeof( Lot ) );
+  lot.operations = (Operation*) malloc( argc * sizeof( Operation ) );
+  int nb_decodeurs = 2, nb_segmenteurs = (int) g_get_num_processors(), nb_ecrivains = 2;
+  int en_vol = 0;
+  int i = 1;
+  for ( ; i < argc - 2; ++i )
+  {
+    Operation* op = &lot.operations[ lot.nb_operations ];
+    if ( strcmp( argv[ i ], "--threshold" ) == 0 && i + 1 < argc - 2 )
+    {
+      ++i;
+      op->type = strcmp( argv[ i ], "auto" ) == 0 ? OPERATION_NIVEAUX : OPERATION_SEUIL;
+      op->valeur = op->type == OPERATION_NIVEAUX ? 2 : atoi( argv[ i ] );
+      lot.nb_operations++;
+    }
+    else if ( strcmp( argv[ i ], "--levels" ) == 0 && i + 1 < argc - 2
+              && atoi( argv[ i + 1 ] ) >= 2 && atoi( argv[ i + 1 ] ) <= CLASSES_MAX )
+    {
+      op->type = OPERATION_NIVEAUX;
+      op->valeur = atoi( argv[ ++i ] );
+      lot.nb_operations++;
+    }
+    else if ( strcmp( argv[ i ], "--components" ) == 0 )
+    {
+      op->type = OPERATION_COMPOSANTES;
+      lot.nb_operations++;
+    }
+    else if ( strcmp( argv[ i ], "--fuzzy" ) == 0 && i + 1 < argc - 2 )
+    {
+      op->type = OPERATION_FLOUES;
+      op->valeur = atof( argv[ ++i ] );
+      lot.nb_operations++;
+    }
+    else if ( strcmp( argv[ i ], "--adaptive" ) == 0 && i + 1 < argc - 2 )
+    {
+      op->type = OPERATION_ADAPTATIVES;
+      op->valeur = atof( argv[ ++i ] );
+      lot.nb_operations++;
+    }
+    else if ( strcmp( argv[ i ], "--connectivity" ) == 0 && i + 1 < argc - 2
+              && ( atoi( argv[ i + 1 ] ) == 4 || atoi( argv[ i + 1 ] ) == 8 ) )
+      choisirConnexite( atoi( argv[ ++i ] ) == 8 ? CONNEXITE_8 : CONNEXITE_4 );
+    else if ( strcmp( argv[ i ], "--threads" ) == 0 && i + 1 < argc - 2 )
+      choisirNombreThreads( atoi( argv[ ++i ] ) );
+    else if ( strcmp( argv[ i ], "--decoders" ) == 0 && i + 1 < argc - 2 )
+      nb_decodeurs = atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--workers" ) == 0 && i + 1 < argc - 2 )
+      nb_segmenteurs = atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--encoders" ) == 0 && i + 1 < argc - 2 )
+      nb_ecrivains = atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--in-flight" ) == 0 && i + 1 < argc - 2 )
+      en_vol = atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--ext" ) == 0 && i + 1 < argc - 2 )
+      lot.extension = argv[ ++i ];
+    else if ( strcmp( argv[ i ], "--cache" ) == 0 && i + 1 < argc - 2 )
+    {
+      const char* dossier = argv[ ++i ];
+      libererCache( lot.cache );
+      lot.cache = creerCache( CAPACITE_CACHE_DEFAUT, strcmp( dossier, "-" ) == 0 ? NULL : dossier );
+    }
+    else
+      break;
+  }
+  if ( i >= argc - 1 || nb_decodeurs < 1 || nb_segmenteurs < 1 || nb_ecrivains < 1 )
+  {
+    usage( argv[ 0 ] );
+    libererCache( lot.cache );
+    free( lot.operations );
+    return 1;
+  }
+  if ( en_vol < 1 ) en_vol = nb_decodeurs + 2 * nb_segmenteurs + nb_ecrivains;
+  if ( strcmp( argv[ argc - 1 ], "-" ) != 0 ) lot.dossier = argv[ argc - 1 ];
+  int ok = TRUE;
+  for ( ; i < argc - 1 && ok; ++i )
+    ok = ajouterEntrees( &lot, argv[ i ] );
+  if ( ok && lot.dossier != NULL && mkdir( lot.dossier, 0777 ) != 0 && errno != EEXIST )
+  {
+    perror( lot.dossier );
+    ok = FALSE;
+  }
+
+  // Les emplacements bornent la mémoire; les files entre les étages
+  // peuvent tous les contenir et ne bloquent donc jamais un dépôt.
+  Travail* travaux = (Travail*) calloc( en_vol, sizeof( Travail ) );
+  lot.libres      = creerFile( en_vol );
+  lot.a_segmenter = creerFile( en_vol );
+  lot.a_ecrire    = creerFile( en_vol );
+  for ( int k = 0; k < en_vol; ++k )
+  {
+    travaux[ k ].tampons = creerTampons();
+    deposerFile( lot.libres, &travaux[ k ] );
+  }
+  pthread_mutex_init( &lot.verrou, NULL );
+  Etage decodage = { "decodage", nb_decodeurs, nb_decodeurs, 0.0, 0 };
+  Etage segmentation = { "segmentation", nb_segmenteurs, nb_segmenteurs, 0.0, 0 };
+  Etage ecriture = { "ecriture", nb_ecrivains, nb_ecrivains, 0.0, 0 };
+  lot.decodage = decodage;
+  lot.segmentation = segmentation;
+  lot.ecriture = ecriture;
+
+  int nb_threads = nb_decodeurs + nb_segmenteurs + nb_ecrivains;
+  pthread_t* threads = (pthread_t*) malloc( nb_threads * sizeof( pthread_t ) );
+  double debut = maintenant();
+  for ( int k = 0; k < nb_threads && ok; ++k )
+    pthread_create( &threads[ k ], NULL,
+                    k < nb_decodeurs ? decoder : k < nb_decodeurs + nb_segmenteurs ? segmenter : ecrire,
+                    &lot );
+  for ( int k = 0; k < nb_threads && ok; ++k )
+    pthread_join( threads[ k ], NULL );
+  double duree = maintenant() - debut;
+
+  if ( ok )
+  {
+    int faites = lot.ecriture.nb_images;
+    printf( "%d images en %.2f ms: %.1f images/s, %d erreurs, au plus %d images en memoire\n",
+            faites, duree, duree > 0.0 ? faites * 1000.0 / duree : 0.0, lot.erreurs, en_vol );
+    afficherEtage( &lot.decodage, duree );
+    afficherEtage( &lot.segmentation, duree );
+    afficherEtage( &lot.ecriture, duree );
+    if ( lot.cache != NULL ) ecrireStatsCache( lot.cache, stdout );
+  }
+  libererCache( lot.cache );
+  free( threads );
+  pthread_mutex_destroy( &lot.verrou );
+  libererFile( lot.a_ecrire );
+  libererFile( lot.a_segmenter );
+  libererFile( lot.libres );
+  for ( int k = 0; k < en_vol; ++k )
+    libererTampons( travaux[ k ].tampons );
+  free( travaux );
+  for ( int k = 0; k < lot.nb_entrees; ++k )
+    free( lot.entrees[ k ] );
+  free( lot.entrees );
+  free( lot.operations );
+  return ok && lot.erreurs == 0 ? 0 : 1;
+}
+
+void usage( const char* prog )
+{
+  fprintf( stderr,
+           "usage: %s [--threshold <seuil|auto>] [--levels <n>] [--components] [--fuzzy <floue>] [--adaptive <k>]"
+           " [--connectivity 4|8] [--threads <n>]"
+           " [--decoders <n>] [--workers <n>] [--encoders <n>] [--in-flight <n>] [--ext <ext>] [--cache <dossier|->]"
+           " <entree|dossier> [...] <dossier de sortie|->\n"
+           "  les operations sont appliquees dans l'ordre donne a chaque image\n"
+           "  --threshold auto, --levels: seuils d'Otsu de chaque image (2 a 16 classes)\n"
+           "  --decoders, --workers, --encoders: threads de chaque etage (2, nombre de coeurs, 2)\n"
+           "  --in-flight: images en memoire au plus (defaut: decoders + 2 workers + encoders)\n"
+           "  --threads: threads par image, en plus (defaut 1)\n"
+           "  --ext: extension (et format) des sorties, sinon celle de l'entree\n"
+           "  --cache: resultats gardes dans <dossier> (ou en memoire avec -) et repris\n"
+           "  pour une image deja segmentee avec les memes reglages\n", prog );
+}
+
+/**
+   Temps courant en ms (horloge monotone).
+*/
+double maintenant( void )
+{
+  struct timespec t;
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+/**
+   Déduit le format gdk-pixbuf ("png", "jpeg", ...) de l'extension du fichier.
+*/
+const char* formatDepuisNom( const char* filename )
+{
+  const char* ext = strrchr( filename, '.' );
+  if ( ext == NULL ) return "png";
+  ++ext;
+  if ( strcasecmp( ext, "jpg" ) == 0 || strcasecmp( ext, "jpeg" ) == 0 ) return "jpeg";
+  if ( strcasecmp( ext, "bmp" ) == 0 ) return "bmp";
+  if ( strcasecmp( ext, "tif" ) == 0 || strcasecmp( ext, "tiff" ) == 0 ) return "tiff";
+  return "png";
+}
+
+void ajouterEntree( Lot* lot, const char* filename )
+{
+  lot->entrees = (char**) realloc( lot->entrees, ( lot->nb_entrees + 1 ) * sizeof( char* ) );
+  lot->entrees[ lot->nb_entrees++ ] = strdup( filename );
+}
+
+static int comparerNoms( const void* a, const void* b )
+{
+  return strcmp( *(char* const*) a, *(char* const*) b );
+}
+
+/**
+   Ajoute \a chemin aux entrées, ou, si c'est un dossier, tous les
+   fichiers qu'il contient (sans les fichiers cachés ni les
+   sous-dossiers), par ordre alphabétique. Rend FALSE en cas d'erreur.
+*/
+bool ajouterEntrees( Lot* lot, const char* chemin )
+{
+  struct stat infos;
+  if ( stat( chemin, &infos ) != 0 )
+  {
+    perror( chemin );
+    return FALSE;
+  }
+  if ( ! S_ISDIR( infos.st_mode ) )
+  {
+    ajouterEntree( lot, chemin );
+    return TRUE;
+  }
+  DIR* dossier = opendir( chemin );
+  if ( dossier == NULL )
+  {
+    perror( chemin );
+    return FALSE;
+  }
+  int premier = lot->nb_entrees;
+  char* nom = (char*) malloc( strlen( chemin ) + 2 );
+  struct dirent* entree;
+  while ( ( entree = readdir( dossier ) ) != NULL )
+  {
+    if ( entree->d_name[ 0 ] == '.' ) continue;
+    nom = (char*) realloc( nom, strlen( chemin ) + strlen( entree->d_name ) + 2 );
+    sprintf( nom, "%s/%s", chemin, entree->d_name );
+    if ( stat( nom, &infos ) == 0 && S_ISREG( infos.st_mode ) )
+      ajouterEntree( lot, nom );
+  }
+  free( nom );
+  closedir( dossier );
+  qsort( lot->entrees + premier, lot->nb_entrees - premier, sizeof( char* ), comparerNoms );
+  return TRUE;
+}
+
+/**
+   Nom de la sortie de l'entrée \a numero: <dossier>/<nom de l'entrée>,
+   avec l'extension --ext si elle est donnée. À libérer.
+*/
+char* nomSortie( const Lot* lot, int numero )
+{
+  const char* entree = lot->entrees[ numero ];
+  const char* base = strrchr( entree, '/' );
+  base = base != NULL ? base + 1 : entree;
+  const char* ext = strrchr( base, '.' );
+  int longueur = lot->extension != NULL && ext != NULL ? (int) ( ext - base ) : (int) strlen( base );
+  size_t taille = strlen( lot->dossier ) + strlen( base ) + ( lot->extension != NULL ? strlen( lot->extension ) : 0 ) + 3;
+  char* nom = (char*) malloc( taille );
+  if ( lot->extension != NULL )
+    sprintf( nom, "%s/%.*s.%s", lot->dossier, longueur, base, lot->extension );
+  else
+    sprintf( nom, "%s/%s", lot->dossier, base );
+  return nom;
+}
+
+/**
+   Compte le temps passé sur une image depuis \a debut dans \a etage,
+   et l'image en erreur s'il y a lieu.
+*/
+void compterImage( Lot* lot, Etage* etage, double debut, bool erreur )
+{
+  double duree = maintenant() - debut;
+  pthread_mutex_lock( &lot->verrou );
+  etage->occupe += duree;
+  if ( erreur ) lot->erreurs++;
+  else          etage->nb_images++;
+  pthread_mutex_unlock( &lot->verrou );
+}
+
+/**
+   Un thread de \a etage a fini; le dernier ferme la file \a suivante,
+   ce qui termine l'étage suivant une fois qu'il l'a vidée.
+*/
+void terminerEtage( Lot* lot, Etage* etage, FileBornee* suivante )
+{
+  pthread_mutex_lock( &lot->verrou );
+  bool dernier = --etage->actifs == 0;
+  pthread_mutex_unlock( &lot->verrou );
+  if ( dernier ) fermerFile( suivante );
+}
+
+/**
+   Étage de décodage: prend un emplacement libre (attend qu'une image
+   soit écrite s'il n'y en a plus), y décode l'entrée suivante et le
+   passe à la segmentation.
+*/
+void* decoder( void* arg )
+{
+  Lot* lot = (Lot*) arg;
+  for ( ;; )
+  {
+    Travail* travail = (Travail*) retirerFile( lot->libres );
+    pthread_mutex_lock( &lot->verrou );
+    int numero = lot->prochain < lot->nb_entrees ? lot->prochain++ : -1;
+    pthread_mutex_unlock( &lot->verrou );
+    if ( numero < 0 )
+    {
+      deposerFile( lot->libres, travail );
+      break;
+    }
+    double debut = maintenant();
+    const char* filename = lot->entrees[ numero ];
+    GError* error = NULL;
+    GdkPixbuf* input = gdk_pixbuf_new_from_file( filename, &error );
+    if ( input == NULL )
+    {
+      fprintf( stderr, "%s: %s\n", filename, error->message );
+      g_error_free( error );
+    }
+    else if ( ! pixbufCompatible( input ) )
+    {
+      fprintf( stderr, "%s: format non supporte (RGB ou RGBA 8 bits attendu)\n", filename );
+      g_object_unref( input );
+      input = NULL;
+    }
+    if ( input == NULL )
+    {
+      compterImage( lot, &lot->decodage, debut, TRUE );
+      deposerFile( lot->libres, travail );
+      continue;
+    }
+    travail->numero = numero;
+    travail->input = input;
+    travail->output = gdk_pixbuf_copy( input );
+    compterImage( lot, &lot->decodage, debut, FALSE );
+    deposerFile( lot->a_segmenter, travail );
+  }
+  terminerEtage( lot, &lot->decodage, lot->a_segmenter );
+  return NULL;
+}
+
+/**
+   Étage de segmentation: applique les opérations, dans l'ordre, à
+   chaque image décodée, avec les tampons de son emplacement.
+*/
+void* segmenter( void* arg )
+{
+  Lot* lot = (Lot*) arg;
+  Travail* travail;
+  while ( ( travail = (Travail*) retirerFile( lot->a_segmenter ) ) != NULL )
+  {
+    double debut = maintenant();
+    Image input  = imageDepuisPixbuf( travail->input );
+    Image output = imageDepuisPixbuf( travail->output );
+    for ( int k = 0; k < lot->nb_operations; ++k )
+    {
+      const Operation* op = &lot->operations[ k ];
+      if ( op->type == OPERATION_SEUIL )
+        seuiller( &input, &output, (int) op->valeur );
+      else if ( op->type == OPERATION_NIVEAUX )
+      {
+        int seuils[ CLASSES_MAX - 1 ];
+        seuillerAutomatique( &input, &output, (int) op->valeur, seuils );
+      }
+      else if ( op->type == OPERATION_COMPOSANTES )
+        calculerComposantesConnexesCache( lot->cache, &input, &output, travail->tampons );
+      else
+      {
+        PlansTSV* plans = NULL;
+        if ( op->type == OPERATION_FLOUES )
+          calculerComposantesConnexesFlouesCache( lot->cache, &input, &output, &plans, op->valeur,
+                                                  travail->tampons, NULL, NULL );
+        else
+          calculerComposantesAdaptativesCache( lot->cache, &input, &output, &plans, op->valeur,
+                                               travail->tampons );
+        libererPlansTSV( plans );
+      }
+    }
+    compterImage( lot, &lot->segmentation, debut, FALSE );
+    deposerFile( lot->a_ecrire, travail );
+  }
+  terminerEtage( lot, &lot->segmentation, lot->a_ecrire );
+  return NULL;
+}
+
+/**
+   Étage d'écriture: enregistre chaque image segmentée, puis rend son
+   emplacement aux décodeurs.
+*/
+void* ecrire( void* arg )
+{
+  Lot* lot = (Lot*) arg;
+  Travail* travail;
+  while ( ( travail = (Travail*) retirerFile( lot->a_ecrire ) ) != NULL )
+  {
+    double debut = maintenant();
+    bool erreur = FALSE;
+    if ( lot->dossier != NULL )
+    {
+      char* filename = nomSortie( lot, travail->numero );
+      GError* error = NULL;
+      if ( ! gdk_pixbuf_save( travail->output, filename, formatDepuisNom( filename ), &error, NULL ) )
+      {
+        fprintf( stderr, "%s: %s\n", filename, error->message );
+        g_error_free( error );
+        erreur = TRUE;
+      }
+      free( filename );
+    }
+    g_object_unref( travail->output );
+    g_object_unref( travail->input );
+    travail->input = travail->output = NULL;
+    compterImage( lot, &lot->ecriture, debut, erreur );
+    deposerFile( lot->libres, travail );
+  }
+  return NULL;
+}
+
+/**
+   Affiche l'occupation de \a etage: la part de \a duree (ms) pendant
+   laquelle ses threads ont travaillé, et le temps moyen par image.
+*/
+void afficherEtage( const Etage* etage, double duree )
+{
+  double occupation = duree > 0.0 ? 100.0 * etage->occupe / ( duree * etage->nb_threads ) : 0.0;
+  printf( "  %-12s %2d threads, occupes a %5.1f %%, %.2f ms par image\n",
+          etage->nom, etage->nb_threads, occupation,
+          etage->nb_images > 0 ? etage->occupe / etage->nb_images : 0.0 );
+}
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include "segmentation.h"
+#include "image-pixbuf.h"
+#include "sequence.h"
+
+/**
+   Segmentation d'une suite d'images: toutes les images d'une animation
+   (GIF animé, ou tout format lu par GdkPixbufAnimation), ou plusieurs
+   fichiers à la suite. Les unions des bandes qui n'ont pas changé
+   depuis l'image précédente sont reprises telles quelles (sequence.h).
+
+   Chaque image segmentée est écrite dans <sortie>-<numéro>.<ext>
+   (out-000.png, out-001.png, ...), sauf avec la sortie "-". Le temps de
+   chaque image (seuillage et segmentation, sans le décodage ni
+   l'écriture) et le débit en images par seconde sont affichés.
+   --from-scratch recalcule chaque image entièrement, pour comparer.
+
+   Une animation qui boucle s'arrête quand elle revient à sa première
+   image (mêmes pixels), ou après --frames images en tout.
+
+   prompt$ ./union-find-sequence --threshold 128 anim.gif out.png
+*/
+
+//-----------------------------------------------------------------------------
+// Déclaration des types
+//-----------------------------------------------------------------------------
+/// État de la lecture des images, d'un fichier à l'autre.
+typedef struct {
+  Sequence* sequence;
+  int seuil;                 // -1: pas de seuillage
+  double floue;              // < 0: composantes de même gris
+  bool complet;              // --from-scratch
+  int max_images;            // 0: pas de limite
+  const char* output_filename;
+  GdkPixbuf* output;         // au format de l'image courante
+  int numero;                // nombre d'images déjà traitées
+  double duree;              // ms, toutes images confondues
+} Lecture;
+
+//-----------------------------------------------------------------------------
+// Déclaration des fonctions
+//-----------------------------------------------------------------------------
+void usage( const char* prog );
+double maintenant( void );
+const char* formatDepuisNom( const char* filename );
+bool traiterImage( Lecture* lecture, GdkPixbuf* image );
+bool lireAnimation( Lecture* lecture, const char* filename );
+
+//-----------------------------------------------------------------------------
+// Programme principal
+//-----------------------------------------------------------------------------
+int main( int   argc,
+          char* argv[] )
+{
+  Lecture lecture;
+  memset( &lecture, 0, sizeof( Lecture ) );
+  lecture.seuil = -1;
+  lecture.floue = -1.0;
+  int hauteur_bande = HAUTEUR_BANDE_SEQUENCE;
+  int i = 1;
+  for ( ; i < argc - 2; ++i )
+  {
+    if ( strcmp( argv[ i ], "--threshold" ) == 0 && i + 1 < argc - 2 )
+      lecture.seuil = atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--fuzzy" ) == 0 && i + 1 < argc - 2 )
+      lecture.floue = atof( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--connectivity" ) == 0 && i + 1 < argc - 2
+              && ( atoi( argv[ i + 1 ] ) == 4 || atoi( argv[ i + 1 ] ) == 8 ) )
+      choisirConnexite( atoi( argv[ ++i ] ) == 8 ? CONNEXITE_8 : CONNEXITE_4 );
+    else if ( strcmp( argv[ i ], "--threads" ) == 0 && i + 1 < argc - 2 )
+      choisirNombreThreads( atoi( argv[ ++i ] ) );
+    else if ( strcmp( argv[ i ], "--band-height" ) == 0 && i + 1 < argc - 2 )
+      hauteur_bande = atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--frames" ) == 0 && i + 1 < argc - 2 )
+      lecture.max_images = atoi( argv[ ++i ] );
+    else if ( strcmp( argv[ i ], "--from-scratch" ) == 0 )
+      lecture.complet = TRUE;
+    else
+      break;
+  }
+  if ( i >= argc - 1 || ( lecture.seuil >= 0 && lecture.floue >= 0.0 ) )
+  {
+    usage( argv[ 0 ] );
+    return 1;
+  }
+  lecture.output_filename = argv[ argc - 1 ];
+  lecture.sequence = creerSequence( hauteur_bande );
+
+  int ok = TRUE;
+  for ( ; i < argc - 1 && ok; ++i )
+    ok = lireAnimation( &lecture, argv[ i ] );
+
+  if ( lecture.numero > 0 )
+  {
+    Sequence* s = lecture.sequence;
+    printf( "%d images en %.2f ms: %.1f images/s, %llu bandes refaites sur %llu\n",
+            lecture.numero, lecture.duree, lecture.numero * 1000.0 / lecture.duree,
+            (unsigned long long) s->bandes_refaites,
+            (unsigned long long) ( s->bandes_refaites + s->bandes_gardees ) );
+  }
+  if ( lecture.output != NULL )
+    g_object_unref( lecture.output );
+  libererSequence( lecture.sequence );
+  return ok ? 0 : 1;
+}
+
+void usage( const char* prog )
+{
+  fprintf( stderr,
+           "usage: %s [--threshold <seuil> | --fuzzy <floue>] [--connectivity 4|8] [--threads <n>]"
+           " [--band-height <lignes>] [--frames <n>] [--from-scratch] <entree> [<entree> ...] <sortie|->\n"
+           "  segmente chaque image de l'animation (ou des fichiers) en reprenant les bandes inchangees\n"
+           "  sortie: <sortie>-000.<ext>, <sortie>-001.<ext>, ... (rien avec -)\n"
+           "  --from-scratch: recalcule chaque image entierement\n", prog );
+}
+
+/**
+   Temps courant en ms (horloge monotone).
+*/
+double maintenant( void )
+{
+  struct timespec t;
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+/**
+   Déduit le format gdk-pixbuf ("png", "jpeg", ...) de l'extension du fichier.
+*/
+const char* formatDepuisNom( const char* filename )
+{
+  const char* ext = strrchr( filename, '.' );
+  if ( ext == NULL ) return "png";
+  ++ext;
+  if ( strcasecmp( ext, "jpg" ) == 0 || strcasecmp( ext, "jpeg" ) == 0 ) return "jpeg";
+  if ( strcasecmp( ext, "bmp" ) == 0 ) return "bmp";
+  if ( strcasecmp( ext, "tif" ) == 0 || strcasecmp( ext, "tiff" ) == 0 ) return "tiff";
+  return "png";
+}
+
+/**
+   Segmente \a image (RGB ou RGBA 8 bits, lue sur place; l'alpha est
+   ignoré et recopié tel quel) et l'écrit. Rend FALSE en cas d'erreur.
+*/
+bool traiterImage( Lecture* lecture, GdkPixbuf* image )
+{
+  int width = gdk_pixbuf_get_width( image );
+  int height = gdk_pixbuf_get_height( image );
+  if ( ! pixbufCompatible( image ) )
+  {
+    fprintf( stderr, "image %d: format non supporte (RGB ou RGBA 8 bits attendu)\n", lecture->numero );
+    return FALSE;
+  }
+  if ( lecture->output == NULL || gdk_pixbuf_get_width( lecture->output ) != width
+       || gdk_pixbuf_get_height( lecture->output ) != height
+       || gdk_pixbuf_get_has_alpha( lecture->output ) != gdk_pixbuf_get_has_alpha( image ) )
+  {
+    if ( lecture->output != NULL )
+      g_object_unref( lecture->output );
+    lecture->output = gdk_pixbuf_new( GDK_COLORSPACE_RGB, gdk_pixbuf_get_has_alpha( image ),
+                                      8, width, height );
+  }
+  Image input = imageDepuisPixbuf( image );
+  Image output = imageDepuisPixbuf( lecture->output );
+
+  double debut = maintenant();
+  for ( int y = 0; y < height; ++y )
+    memcpy( output.data + (size_t) y * output.rowstride,
+            input.data + (size_t) y * input.rowstride, (size_t) input.canaux * width );
+  if ( lecture->seuil >= 0 )
+    seuiller( &input, &output, lecture->seuil );
+  if ( lecture->complet ) oublierSequence( lecture->sequence );
+  int refaites = segmenterImageSequence( lecture->sequence, &input, &output, lecture->floue );
+  double duree = maintenant() - debut;
+  lecture->duree += duree;
+  printf( "image %d: %.2f ms, %d bandes refaites sur %d\n",
+          lecture->numero, duree, refaites, lecture->sequence->nb_bandes );
+
+  bool ok = TRUE;
+  if ( strcmp( lecture->output_filename, "-" ) != 0 )
+  {
+    const char* filename = lecture->output_filename;
+    const char* ext = strrchr( filename, '.' );
+    int base = ext != NULL ? (int) ( ext - filename ) : (int) strlen( filename );
+    if ( ext == NULL ) ext = "";
+    char* nom = (char*) malloc( strlen( filename ) + 16 );
+    sprintf( nom, "%.*s-%03d%s", base, filename, lecture->numero, ext );
+    GError* error = NULL;
+    if ( ! gdk_pixbuf_save( lecture->output, nom, formatDepuisNom( nom ), &error, NULL ) )
+    {
+      fprintf( stderr, "%s: %s\n", nom, error->message );
+      g_error_free( error );
+      ok = FALSE;
+    }
+    free( nom );
+  }
+  lecture->numero += 1;
+  return ok;
+}
+
+/**
+   Segmente les images d'une boucle de \a filename, ou jusqu'à la limite
+   --frames. Les délais de l'animation servent seulement à passer d'une
+   image à la suivante: la boucle est finie quand le temps écoulé atteint
+   la somme des délais, c'est-à-dire après la dernière image. Une image
+   qui revient au milieu de la boucle est donc segmentée à nouveau.
+   Rend FALSE en cas d'erreur.
+*/
+bool lireAnimation( Lecture* lecture, const char* filename )
+{
+  GError* error = NULL;
+  GdkPixbufAnimation* animation = gdk_pixbuf_animation_new_from_file( filename, &error );
+  if ( animation == NULL )
+  {
+    fprintf( stderr, "%s: %s\n", filename, error->message );
+    g_error_free( error );
+    return FALSE;
+  }
+  bool ok = TRUE;
+  if ( gdk_pixbuf_animation_is_static_image( animation ) )
+  {
+    if ( lecture->max_images == 0 || lecture->numero < lecture->max_images )
+      ok = traiterImage( lecture, gdk_pixbuf_animation_get_static_image( animation ) );
+  }
+  else
+  {
+    // GdkPixbufAnimationIter n'existe qu'avec des GTimeVal.
+    G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+    GTimeVal temps = { 0, 0 };
+    GdkPixbufAnimationIter* iter = gdk_pixbuf_animation_get_iter( animation, &temps );
+    while ( ok && ( lecture->max_images == 0 || lecture->numero < lecture->max_images ) )
+    {
+      ok = traiterImage( lecture, gdk_pixbuf_animation_iter_get_pixbuf( iter ) );
+      int delai = gdk_pixbuf_animation_iter_get_delay_time( iter );
+      if ( delai < 0 ) break; // dernière image d'une animation qui ne boucle pas
+      // Le fichier est chargé en entier: l'image « en cours de
+      // chargement » est la dernière, après laquelle l'itérateur repart
+      // au début.
+      if ( gdk_pixbuf_animation_iter_on_currently_loading_frame( iter ) ) break;
+      g_time_val_add( &temps, ( delai > 0 ? delai : 1 ) * 1000L );
+      gdk_pixbuf_animation_iter_advance( iter, &temps );
+    }
+    G_GNUC_END_IGNORE_DEPRECATIONS
+    g_object_unref( iter );
+  }
+  g_object_unref( animation );
+  return ok;
+}
@@ -1,14 +1,43 @@
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 #include <gtk/gtk.h>
 #include <time.h>
-
-#define bool int
+#include "segmentation.h"
+#include "image-pixbuf.h"
+#include "plans-tsv.h"
+#include "arbre-alpha.h"
+#include "tampons.h"
+#include "seuillage.h"
+#include "pyramide.h"
+#include "cache.h"
 
 //-----------------------------------------------------------------------------
 // Déclaration des types
 //-----------------------------------------------------------------------------
+/// Calculs confiés au thread de travail.
+typedef enum {
+  CALCUL_COMPOSANTES,
+  CALCUL_FLOUES
+} TypeCalcul;
+
+/**
+   Une demande de calcul. Le résultat est calculé dans \a pixbuf (une
+   copie de la sortie au moment de la demande), puis remplace la sortie
+   affichée si aucune demande plus récente n'est arrivée entre temps.
+*/
+typedef struct {
+  TypeCalcul type;
+  double floue;
+  bool plages;
+  bool temps_reel;
+  bool progressif;
+  Connexite connexite;
+  gint generation;   // numéro de la demande
+  GdkPixbuf* pixbuf;
+} Demande;
+
 /**
    Le contexte contient les informations utiles de l'interface pour
    les algorithmes de traitement d'image.  
@@ -21,47 +50,33 @@ typedef struct SContexte {
   GtkWidget* image;
   GtkWidget* seuil;
   GtkWidget* floue;
+  GtkWidget* plages; // case "par plages" pour les composantes connexes
+  GtkWidget* temps_reel; // case "temps réel": recalcul des floues à chaque mouvement du curseur
+  GtkWidget* huit_voisins; // case "8-connexité" pour toutes les composantes
+  GtkWidget* progressif; // case "aperçus progressifs" pour les floues
+  PlansTSV* plans;   // plans TSV de l'entrée, calculés au premier clic "floues"
+  ArbreAlpha* arbre; // arbre alpha de l'entrée, construit au premier usage du temps réel
+  Pyramide* pyramide; // entrée réduite, construite au premier aperçu progressif
+  Tampons* tampons;  // forêt, étiquettes et couleurs, réutilisées d'un clic à l'autre
+  Cache* cache;      // résultats déjà calculés (en mémoire), repeints sans refaire les unions
+  GtkWidget* progression; // avancement du calcul en cours
+  // Les plans, l'arbre, la pyramide, les tampons et le cache ne sont utilisés que par le thread de travail.
+  GThread* travailleur;
+  GMutex verrou;     // protège demande et en_attente
+  GCond reveil;
+  Demande demande;   // dernière demande pas encore commencée
+  bool en_attente;
+  gint generation;   // numéro de la dernière demande (accès atomiques)
 } Contexte;
 
-/**
-   Un pixel est une structure de 3 octets (rouge, vert, bleu). On les
-   plaque au bon endroit dans un pixbuf pour modifier les couleurs du pixel.
- */
-typedef struct {
-  guchar rouge;
-  guchar vert;
-  guchar bleu;
-} Pixel;
-
-/**
-   Un Objet est un un wrapper d'un pixel permettant l'organisation en forêt.
-   Un pixel a maintenant un rang et un père.
-   Un ancètre dont le père est lui même s'appelle la racine.
- */
-typedef struct SObjet {
-  Pixel* pixel; // adresse du pixel dans le pixbuf
-  int rang;
-  struct SObjet* pere;
-} Objet;
-
-/**
-  structure pour stocker la moyenne des couleurs
-*/
-typedef struct {
-  double rouge;
-  double vert;
-  double bleu;
-  int nb;
-} StatCouleur;
-
-/**
-  structure de couleur au format TSV
-*/
+/// Message du thread de travail vers la boucle principale.
 typedef struct {
-  int t;    // teinte comme angle en degrés
-  double s; // saturation comme nombre entre 0 et 1
-  double v; // valeur ou brillance comme nombre entre 0 et 1
-} TSVCouleur;
+  Contexte* ctx;
+  gint generation;
+  PhaseSegmentation phase;
+  GdkPixbuf* pixbuf; // résultat, pour AVANCEMENT_FINI
+  bool apercu;       // pixbuf est un aperçu, affiché mais pas gardé comme sortie
+} Nouvelle;
 
 //-----------------------------------------------------------------------------
 // Déclaration des fonctions
@@ -69,24 +84,24 @@ typedef struct {
 gboolean selectInput( GtkWidget *widget, gpointer data );
 gboolean selectOutput( GtkWidget *widget, gpointer data );
 gboolean seuillerImage( GtkWidget *widget, gpointer data );
+gboolean seuillerOtsu( GtkWidget *widget, gpointer data );
 gboolean composantesConnexes( GtkWidget *widget, gpointer data );
 gboolean composantesConnexesFloues( GtkWidget *widget, gpointer data );
+void floueChangee( GtkRange* range, gpointer data );
+void demanderCalcul( Contexte* ctx, TypeCalcul type );
+gpointer travailler( gpointer data );
+void executerDemande( Contexte* ctx, Demande* demande );
+bool avancer( PhaseSegmentation phase, void* data );
+gboolean afficherNouvelle( gpointer data );
+void envoyerApercu( const Image* apercu, int niveau, void* data );
+bool envoyerApercus( const Image* input, double floue, Tampons* tampons, void* data );
+gboolean exporterMesures( GtkWidget *widget, gpointer data );
 GtkWidget* creerIHM( const char* image_filename, Contexte* pCtxt );
 void analyzePixbuf( GdkPixbuf* pixbuf );
-GdkPixbuf* creerImage( int width, int height );
-unsigned char greyLevel( Pixel* data );
-void setGreyLevel( Pixel* data, unsigned char g );
+GdkPixbuf* creerImage( int width, int height, bool alpha );
 Pixel* gotoPixel( GdkPixbuf* pixbuf, int x, int y );
 void disk( GdkPixbuf* pixbuf, int r );
 
-Objet* creerEnsembles( GdkPixbuf* pixbuf );
-Objet* trouverPasOpti( Objet* obj );
-void unionPasOpti( Objet* obj1, Objet* obj2 );
-Objet* trouverOpti( Objet* obj );
-void unionOpti( Objet* obj1, Objet* obj2 );
-TSVCouleur tsv( Pixel* pixel );
-double similitude( Pixel* p1, Pixel* p2 );
-
 
 //-----------------------------------------------------------------------------
 // Programme principal
@@ -99,6 +114,8 @@ int main( int   argc,
 
   /* Passe les arguments à GTK, pour qu'il extrait ceux qui le concernent. */
   gtk_init( &argc, &argv );
+  /* Les composantes connexes utilisent tous les coeurs. */
+  choisirNombreThreads( g_get_num_processors() );
   
   /* Crée une fenêtre. */
   creerIHM( image_filename, &context );
@@ -136,180 +153,274 @@ gboolean selectOutput( GtkWidget *widget, gpointer data )
 gboolean seuillerImage( GtkWidget *widget, gpointer data )
 {
   Contexte* ctx = (Contexte*) data;
-  guchar* dataInput = gdk_pixbuf_get_pixels( ctx->pixbuf_input );          // Pointeur vers le tampon de données
-  guchar* dataOutput = gdk_pixbuf_get_pixels( ctx->pixbuf_output );          // Pointeur vers le tampon de données
-  int rowstrideIn = gdk_pixbuf_get_rowstride( ctx->pixbuf_input ); // nmb octets dans la ligne
-  int rowstrideOut = gdk_pixbuf_get_rowstride( ctx->pixbuf_output ); // nmb octets dans la ligne
+  Image input  = imageDepuisPixbuf( ctx->pixbuf_input );
+  Image output = imageDepuisPixbuf( ctx->pixbuf_output );
   int seuilValue = gtk_range_get_value( GTK_RANGE( ctx->seuil ) );
 
-  for ( int y = 0; y < ctx->height; ++y )
-  {
-    Pixel* pixelIn = (Pixel*) dataInput;
-    Pixel* pixelOut = (Pixel*) dataOutput;
-    for ( int x = 0; x < ctx->width; ++x ) 
-      {
-        if (seuilValue > greyLevel(pixelIn))
-          setGreyLevel(pixelOut,0);
-        else
-          setGreyLevel(pixelOut,255);
-
-        ++pixelIn;
-        ++pixelOut;
-      }
-    dataOutput += rowstrideOut; // passe à la ligne suivante
-    dataInput += rowstrideIn;
-  }
+  // Le seuillage est immédiat; il abandonne le calcul en cours, dont le
+  // résultat écraserait la sortie seuillée.
+  g_atomic_int_inc( &ctx->generation );
+  gtk_progress_bar_set_fraction( GTK_PROGRESS_BAR( ctx->progression ), 0.0 );
+  seuiller( &input, &output, seuilValue );
   return TRUE;
 }
 
+/**
+   Place le curseur du seuil sur le seuil d'Otsu de l'entrée
+   (seuillage.h), puis seuille.
+*/
+gboolean seuillerOtsu( GtkWidget *widget, gpointer data )
+{
+  Contexte* ctx = (Contexte*) data;
+  Image input = imageDepuisPixbuf( ctx->pixbuf_input );
+  uint32_t histogramme[ 256 ];
+  int seuil;
+  histogrammeImage( &input, histogramme );
+  seuilsOtsu( histogramme, 2, &seuil );
+  gtk_range_set_value( GTK_RANGE( ctx->seuil ), seuil );
+  return seuillerImage( widget, data );
+}
+
 gboolean composantesConnexes( GtkWidget *widget, gpointer data )
 {
-  Contexte *ctx = (Contexte*) data;
-  // 1
-  Objet *objects = creerEnsembles(ctx->pixbuf_output);
-  int size = ( ctx->width ) * ( ctx->height );
+  demanderCalcul( (Contexte*) data, CALCUL_COMPOSANTES );
+  return TRUE;
+}
 
-  for(int i = 0 /*2*/; i < size; i++)
-  {
-    // 3a
-    bool isLastColumn = (i % ctx->width) == ctx->width - 1;
-    if(!isLastColumn && greyLevel(objects[i].pixel) == greyLevel(objects[i+1].pixel))
-      unionOpti(&objects[i], &objects[i+1]);
-    // 3b
-    bool isLastLine = i >= (size - ctx-> width);
-    if( !isLastLine && greyLevel(objects[i].pixel) == greyLevel(objects[i+ctx->width].pixel))
-      unionOpti(&objects[i],&objects[i+ctx->width]);
-  }
+gboolean composantesConnexesFloues( GtkWidget *widget, gpointer data )
+{
+  demanderCalcul( (Contexte*) data, CALCUL_FLOUES );
+  return TRUE;
+}
 
-  // 4 & 5
-  StatCouleur *stats = (StatCouleur*) calloc( 4, size * sizeof(StatCouleur) );
+/// Fonction appelée quand le curseur "floue" bouge.
+void floueChangee( GtkRange* range, gpointer data )
+{
+  Contexte *ctx = (Contexte*) data;
+  if ( gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( ctx->temps_reel ) ) )
+    demanderCalcul( ctx, CALCUL_FLOUES );
+}
 
-  // 6
-  guchar* data_input  = gdk_pixbuf_get_pixels( ctx ->pixbuf_input );
-  guchar* data_output = gdk_pixbuf_get_pixels( ctx ->pixbuf_output );
-  for ( int i = 0; i < size; ++i )
-  {
-    Objet* rep = trouverOpti( &objects[ i ] ); // tu trouve le représentant
-    long int j = rep - objects; // tu trouve sons indice dans les tableaux
-    Pixel* pixel_src = (Pixel*) ( data_input + ( (guchar*) objects[ i ].pixel - data_output ) ); 
-    // pixel_src est la couleur de ce pixel dans l'image input.
-    // On l'ajoute à la stat du représentant j.
-    stats[ j ].rouge += pixel_src->rouge;
-    stats[ j ].vert  += pixel_src->vert;
-    stats[ j ].bleu  += pixel_src->bleu;
-    stats[ j ].nb += 1; // On aura donc la somme cumulée
-  }
+/**
+   Confie un calcul au thread de travail, sans attendre. Le calcul en
+   cours est abandonné à sa prochaine phase, et une demande pas encore
+   commencée est remplacée: seule la plus récente compte.
+*/
+void demanderCalcul( Contexte* ctx, TypeCalcul type )
+{
+  Demande demande;
+  demande.type = type;
+  demande.floue = gtk_range_get_value( GTK_RANGE( ctx->floue ) );
+  demande.plages = gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( ctx->plages ) );
+  demande.temps_reel = gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( ctx->temps_reel ) );
+  demande.progressif = gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( ctx->progressif ) );
+  demande.connexite = gtk_toggle_button_get_active( GTK_TOGGLE_BUTTON( ctx->huit_voisins ) )
+    ? CONNEXITE_8 : CONNEXITE_4;
+  demande.pixbuf = gdk_pixbuf_copy( ctx->pixbuf_output );
+  demande.generation = g_atomic_int_add( &ctx->generation, 1 ) + 1;
+
+  g_mutex_lock( &ctx->verrou );
+  if ( ctx->en_attente )
+    g_object_unref( ctx->demande.pixbuf );
+  ctx->demande = demande;
+  ctx->en_attente = TRUE;
+  g_cond_signal( &ctx->reveil );
+  g_mutex_unlock( &ctx->verrou );
+
+  if ( ctx->travailleur == NULL )
+    ctx->travailleur = g_thread_new( "segmentation", travailler, ctx );
+}
 
-  // 7
-  for ( int i = 0; i < size; ++i )
+/**
+   Boucle du thread de travail: attend une demande, la calcule, recommence.
+*/
+gpointer travailler( gpointer data )
+{
+  Contexte* ctx = (Contexte*) data;
+  g_mutex_lock( &ctx->verrou );
+  for ( ;; )
   {
-    // C'est un représentant
-    if (stats[ i ].nb != 0) {
-      objects[ i ].pixel->rouge = stats[ i ].rouge / stats[ i ].nb;
-      objects[ i ].pixel->vert  = stats[ i ].vert  / stats[ i ].nb;
-      objects[ i ].pixel->bleu  = stats[ i ].bleu  / stats[ i ].nb;
-    }
+    while ( ! ctx->en_attente )
+      g_cond_wait( &ctx->reveil, &ctx->verrou );
+    Demande demande = ctx->demande;
+    ctx->en_attente = FALSE;
+    g_mutex_unlock( &ctx->verrou );
+    executerDemande( ctx, &demande );
+    g_mutex_lock( &ctx->verrou );
   }
+  return NULL;
+}
 
-  free(stats);
-
-  // 8
-  for ( int i = 0; i < size; ++i )
-  {
-    Objet* rep = trouverOpti( &objects[ i ] ); // tu trouve le représentant
-    objects[ i ].pixel->rouge = rep->pixel->rouge;
-    objects[ i ].pixel->bleu  = rep->pixel->bleu;
-    objects[ i ].pixel->vert  = rep->pixel->vert;
-  }
+/// Envoie une nouvelle du calcul à la boucle principale.
+static void envoyerNouvelle( Contexte* ctx, gint generation, PhaseSegmentation phase, GdkPixbuf* pixbuf )
+{
+  Nouvelle* n = (Nouvelle*) g_malloc( sizeof( Nouvelle ) );
+  n->ctx = ctx;
+  n->generation = generation;
+  n->phase = phase;
+  n->pixbuf = pixbuf;
+  n->apercu = FALSE;
+  g_idle_add( afficherNouvelle, n );
+}
 
-  // Place le pixbuf à visualiser dans le bon widget.
-  gtk_image_set_from_pixbuf( GTK_IMAGE( ctx->image ), ctx->pixbuf_output );
-  // Force le réaffichage du widget.
-  gtk_widget_queue_draw( ctx->image );
+/// Suivi des tampons pour la demande en cours (voir tampons.h).
+typedef struct {
+  Contexte* ctx;
+  gint generation;
+} Suivi;
 
+/**
+   Appelée par les calculs au début de chaque phase: affiche la phase,
+   et interrompt le calcul si une demande plus récente est arrivée.
+*/
+bool avancer( PhaseSegmentation phase, void* data )
+{
+  Suivi* suivi = (Suivi*) data;
+  if ( g_atomic_int_get( &suivi->ctx->generation ) != suivi->generation )
+    return FALSE;
+  if ( phase != AVANCEMENT_FINI )
+    envoyerNouvelle( suivi->ctx, suivi->generation, phase, NULL );
   return TRUE;
 }
 
-gboolean composantesConnexesFloues( GtkWidget *widget, gpointer data )
+/**
+   Envoie à la boucle principale un aperçu (pyramide.h), agrandi à la
+   taille de l'entrée.
+*/
+void envoyerApercu( const Image* apercu, int niveau, void* data )
 {
-  Contexte *ctx = (Contexte*) data;
-
-  // copie par valeur
-  ctx->pixbuf_output = gdk_pixbuf_copy(ctx->pixbuf_input);
+  Suivi* suivi = (Suivi*) data;
+  GdkPixbuf* petit = gdk_pixbuf_new( GDK_COLORSPACE_RGB, apercu->canaux == 4, 8,
+                                     apercu->width, apercu->height );
+  for ( int y = 0; y < apercu->height; ++y )
+    memcpy( gdk_pixbuf_get_pixels( petit ) + y * gdk_pixbuf_get_rowstride( petit ),
+            apercu->data + y * apercu->rowstride, apercu->width * apercu->canaux );
+  Nouvelle* n = (Nouvelle*) g_malloc( sizeof( Nouvelle ) );
+  n->ctx = suivi->ctx;
+  n->generation = suivi->generation;
+  n->phase = AVANCEMENT_UNIONS;
+  n->pixbuf = gdk_pixbuf_scale_simple( petit, suivi->ctx->width, suivi->ctx->height, GDK_INTERP_NEAREST );
+  n->apercu = TRUE;
+  g_object_unref( petit );
+  g_idle_add( afficherNouvelle, n );
+}
 
-  double floue = gtk_range_get_value( GTK_RANGE( ctx->floue ) );
-  // 1
-  Objet *objects = creerEnsembles(ctx->pixbuf_output);
-  int size = ( ctx->width ) * ( ctx->height );
+/**
+   Avant un calcul flou absent du cache (cache.h): aperçus du plus
+   grossier au plus fin, avant même les plans de l'entrée.
+*/
+bool envoyerApercus( const Image* input, double floue, Tampons* tampons, void* data )
+{
+  Suivi* suivi = (Suivi*) data;
+  Contexte* ctx = suivi->ctx;
+  if ( ctx->pyramide == NULL )
+    ctx->pyramide = creerPyramide( input, COTE_APERCU );
+  return apercusFloues( ctx->pyramide, floue, tampons, envoyerApercu, suivi );
+}
 
-  for(int i = 0 /*2*/; i < size; i++)
+/**
+   Calcule \a demande dans le thread de travail, puis envoie le résultat
+   à la boucle principale (sauf si le calcul a été abandonné).
+*/
+void executerDemande( Contexte* ctx, Demande* demande )
+{
+  Suivi suivi = { ctx, demande->generation };
+  suivreTampons( ctx->tampons, avancer, &suivi );
+  Image input  = imageDepuisPixbuf( ctx->pixbuf_input );
+  Image output = imageDepuisPixbuf( demande->pixbuf );
+  bool fini;
+
+  choisirConnexite( demande->connexite );
+  if ( demande->type == CALCUL_COMPOSANTES )
   {
-    // 3a
-    bool isLastColumn = (i % ctx->width) == ctx->width - 1;
-    // printf("sim : %f\n",similitude(objects[ i ].pixel, objects[ i+1 ].pixel));
-    if(!isLastColumn && similitude(objects[ i ].pixel, objects[ i+1 ].pixel) <= floue)
-      unionOpti(&objects[ i ], &objects[ i+1 ]);
-    // 3b
-    bool isLastLine = i >= (size - ctx-> width);
-    if( !isLastLine && similitude(objects[ i ].pixel, objects[ i + ctx->width ].pixel) <= floue)
-      unionOpti(&objects[ i ], &objects[ i + ctx->width ]);
+    choisirMoteurComposantes( demande->plages ? COMPOSANTES_PAR_PLAGES : COMPOSANTES_PAR_PIXELS );
+    fini = calculerComposantesConnexesCache( ctx->cache, &input, &output, ctx->tampons );
   }
+  else if ( demande->temps_reel )
+  { // Une fois l'arbre construit, chaque seuil se lit en temps linéaire.
+    fini = avancer( AVANCEMENT_UNIONS, &suivi );
+    // L'entrée ne change pas: on ne convertit en TSV qu'une fois.
+    if ( fini && ctx->plans == NULL )
+      ctx->plans = creerPlansTSV( &input );
+    if ( fini && ctx->arbre != NULL && ctx->arbre->connexite != demande->connexite )
+    {
+      libererArbreAlpha( ctx->arbre );
+      ctx->arbre = NULL;
+    }
+    if ( fini && ctx->arbre == NULL )
+      ctx->arbre = construireArbreAlpha( ctx->plans );
+    fini = fini && avancer( AVANCEMENT_REPEINT, &suivi );
+    if ( fini )
+      composantesArbreAlpha( ctx->arbre, &input, &output, demande->floue );
+  }
+  else
+  { // Un seuil déjà essayé est repeint aussitôt, sans aperçus ni plans.
+    fini = calculerComposantesConnexesFlouesCache( ctx->cache, &input, &output, &ctx->plans, demande->floue,
+                                                   ctx->tampons, demande->progressif ? envoyerApercus : NULL,
+                                                   &suivi );
+  }
+  suivreTampons( ctx->tampons, NULL, NULL );
+  INSTRUMENTER( instrumentationFusionner(); )
 
-  // 4 & 5
-  StatCouleur *stats = (StatCouleur*) calloc( 4, size * sizeof(StatCouleur) );
-
-  // 6
-  guchar* data_input  = gdk_pixbuf_get_pixels( ctx ->pixbuf_input );
-  guchar* data_output = gdk_pixbuf_get_pixels( ctx ->pixbuf_output );
+  if ( fini )
+    envoyerNouvelle( ctx, demande->generation, AVANCEMENT_FINI, demande->pixbuf );
+  else
+    g_object_unref( demande->pixbuf );
+}
 
-  for ( int i = 0; i < size; ++i )
+/**
+   Écrit les compteurs de l'instrumentation (instrumentation.h) dans
+   instrumentation.json, dans le répertoire courant.
+*/
+gboolean exporterMesures( GtkWidget *widget, gpointer data )
+{
+  const char* nom = "instrumentation.json";
+  FILE* f = fopen( nom, "w" );
+  if ( f == NULL )
   {
-    Objet* rep = trouverOpti( &objects[ i ] ); // tu trouve le représentant
-    long int j = rep - objects; // tu trouve sons indice dans les tableaux
-    Pixel* pixel_src = (Pixel*) ( data_input + ( (guchar*) objects[ i ].pixel - data_output ) ); 
-    // pixel_src est la couleur de ce pixel dans l'image input.
-    // On l'ajoute à la stat du représentant j.
-    stats[ j ].rouge += pixel_src->rouge;
-    stats[ j ].vert  += pixel_src->vert;
-    stats[ j ].bleu  += pixel_src->bleu;
-    stats[ j ].nb += 1; // On aura donc la somme cumulée
+    perror( nom );
+    return TRUE;
   }
+  ecrireInstrumentationJSON( f );
+  fclose( f );
+  printf( "Mesures écrites dans %s\n", nom );
+  return TRUE;
+}
 
-  // 7
-  for ( int i = 0; i < size; ++i )
+/**
+   Dans la boucle principale: affiche l'avancement ou le résultat d'un
+   calcul, s'il correspond toujours à la dernière demande.
+*/
+gboolean afficherNouvelle( gpointer data )
+{
+  static const char* NOMS_PHASES[] = { "Empreinte", "Unions", "Statistiques", "Recoloriage", "Fini" };
+  Nouvelle* n = (Nouvelle*) data;
+  Contexte* ctx = n->ctx;
+  if ( n->generation == g_atomic_int_get( &ctx->generation ) )
   {
-    // C'est un représentant
-    if (stats[ i ].nb != 0) {
-      objects[ i ].pixel->rouge = stats[ i ].rouge / stats[ i ].nb;
-      objects[ i ].pixel->vert  = stats[ i ].vert  / stats[ i ].nb;
-      objects[ i ].pixel->bleu  = stats[ i ].bleu  / stats[ i ].nb;
+    gtk_progress_bar_set_fraction( GTK_PROGRESS_BAR( ctx->progression ), n->phase / 4.0 );
+    gtk_progress_bar_set_text( GTK_PROGRESS_BAR( ctx->progression ),
+                               n->apercu ? "Aperçu" : NOMS_PHASES[ n->phase ] );
+    if ( n->apercu )
+    { // La sortie reste celle d'avant: l'aperçu n'est qu'affiché.
+      gtk_image_set_from_pixbuf( GTK_IMAGE( ctx->image ), n->pixbuf );
+      gtk_widget_queue_draw( ctx->image );
+    }
+    else if ( n->pixbuf != NULL )
+    {
+      g_object_unref( ctx->pixbuf_output );
+      ctx->pixbuf_output = n->pixbuf;
+      n->pixbuf = NULL;
+      // Place le pixbuf à visualiser dans le bon widget.
+      gtk_image_set_from_pixbuf( GTK_IMAGE( ctx->image ), ctx->pixbuf_output );
+      // Force le réaffichage du widget.
+      gtk_widget_queue_draw( ctx->image );
     }
   }
-
-  free(stats);
-
-  // 8
-  for ( int i = 0; i < size; ++i )
-  {
-    Objet* rep = trouverOpti( &objects[ i ] ); // tu trouve le représentant
-    objects[ i ].pixel->rouge = rep->pixel->rouge;
-    objects[ i ].pixel->bleu  = rep->pixel->bleu;
-    objects[ i ].pixel->vert  = rep->pixel->vert;
-  }
-
-
-  // struct timespec current; // Stoppe l'horloge
-  // clock_gettime(CLOCK_REALTIME, &current); //Linux gettime
-  // double t = (( current.tv_sec - myTimerStart.tv_sec) *1000 +
-  //          ( current.tv_nsec - myTimerStart.tv_nsec)/1000000.0);
-  // printf( "time = %lf ms.\n", t );
-
-  // Place le pixbuf à visualiser dans le bon widget.
-  gtk_image_set_from_pixbuf( GTK_IMAGE( ctx->image ), ctx->pixbuf_output );
-  // Force le réaffichage du widget.
-  gtk_widget_queue_draw( ctx->image );
-
-  return TRUE;
+  if ( n->pixbuf != NULL )
+    g_object_unref( n->pixbuf );
+  g_free( n );
+  return G_SOURCE_REMOVE;
 }
 
 /// Charge l'image donnée et crée l'interface.
@@ -326,7 +437,14 @@ GtkWidget* creerIHM( const char* image_filename, Contexte* pCtxt )
   GtkWidget* floue_widget;
   GtkWidget* floue_button;
   GtkWidget* seuil_button;
+  GtkWidget* otsu_button;
   GtkWidget* connexe_button;
+  GtkWidget* plages_button;
+  GtkWidget* temps_reel_button;
+  GtkWidget* huit_voisins_button;
+  GtkWidget* progressif_button;
+  GtkWidget* progression;
+  GtkWidget* mesures_button;
   GError**   error = NULL;
 
   /* Crée une fenêtre. */
@@ -342,12 +460,23 @@ GtkWidget* creerIHM( const char* image_filename, Contexte* pCtxt )
   pCtxt->seuil = seuil_widget;
   floue_widget = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 0, 255, 1 );
   pCtxt->floue = floue_widget;
+  pCtxt->plans = NULL;
+  pCtxt->arbre = NULL;
+  pCtxt->pyramide = NULL;
+  pCtxt->tampons = creerTampons();
+  pCtxt->cache = creerCache( CAPACITE_CACHE_DEFAUT, NULL );
+  pCtxt->travailleur = NULL;
+  pCtxt->en_attente = FALSE;
+  pCtxt->generation = 0;
+  g_mutex_init( &pCtxt->verrou );
+  g_cond_init( &pCtxt->reveil );
 
   // Crée le pixbuf source et le pixbuf destination
   pCtxt->pixbuf_input  = gdk_pixbuf_new_from_file( image_filename, error );
   pCtxt->width         = gdk_pixbuf_get_width( pCtxt->pixbuf_input );           // Largeur de l'image en pixels
   pCtxt->height        = gdk_pixbuf_get_height( pCtxt->pixbuf_input );          // Hauteur de l'image en pixels
-  pCtxt->pixbuf_output = creerImage( pCtxt->width, pCtxt->height );
+  pCtxt->pixbuf_output = creerImage( pCtxt->width, pCtxt->height,
+                                     gdk_pixbuf_get_has_alpha( pCtxt->pixbuf_input ) );
   analyzePixbuf( pCtxt->pixbuf_input );
   disk( pCtxt->pixbuf_output, 100 );
   // Crée le widget qui affiche le pixbuf image.
@@ -361,9 +490,21 @@ GtkWidget* creerIHM( const char* image_filename, Contexte* pCtxt )
   button_select_output = gtk_button_new_with_label( "Output" );
   // Creer le bouton seuil
   seuil_button = gtk_button_new_with_label( "Seuiller");
+  otsu_button = gtk_button_new_with_label( "Seuil automatique (Otsu)" );
   floue_button = gtk_button_new_with_label( "Composantes connexes floues");
+  temps_reel_button = gtk_check_button_new_with_label( "Temps réel" );
+  pCtxt->temps_reel = temps_reel_button;
+  progression = gtk_progress_bar_new();
+  gtk_progress_bar_set_show_text( GTK_PROGRESS_BAR( progression ), TRUE );
+  pCtxt->progression = progression;
 
   connexe_button = gtk_button_new_with_label( "Composantes connexes" );
+  plages_button = gtk_check_button_new_with_label( "Par plages" );
+  pCtxt->plages = plages_button;
+  huit_voisins_button = gtk_check_button_new_with_label( "8-connexité" );
+  pCtxt->huit_voisins = huit_voisins_button;
+  progressif_button = gtk_check_button_new_with_label( "Aperçus progressifs" );
+  pCtxt->progressif = progressif_button;
   // Connecte la réaction gtk_main_quit à l'événement "clic" sur ce bouton.
   g_signal_connect( button_select_input, "clicked",
                     G_CALLBACK( selectInput ),
@@ -374,12 +515,18 @@ GtkWidget* creerIHM( const char* image_filename, Contexte* pCtxt )
   g_signal_connect( seuil_button, "clicked",
                     G_CALLBACK(seuillerImage),
                     pCtxt );
+  g_signal_connect( otsu_button, "clicked",
+                    G_CALLBACK(seuillerOtsu),
+                    pCtxt );
   g_signal_connect( connexe_button, "clicked",
                     G_CALLBACK(composantesConnexes),
                     pCtxt );
   g_signal_connect( floue_button, "clicked",
                     G_CALLBACK(composantesConnexesFloues),
                     pCtxt );
+  g_signal_connect( floue_widget, "value-changed",
+                    G_CALLBACK(floueChangee),
+                    pCtxt );
   gtk_container_add( GTK_CONTAINER( vbox2 ), button_select_input );
   gtk_container_add( GTK_CONTAINER( vbox2 ), button_select_output );
   // Crée le bouton quitter.
@@ -392,10 +539,25 @@ GtkWidget* creerIHM( const char* image_filename, Contexte* pCtxt )
   gtk_container_add( GTK_CONTAINER( vbox1 ), hbox1 );
   gtk_container_add( GTK_CONTAINER( vbox1 ), seuil_widget );
   gtk_container_add( GTK_CONTAINER( vbox1 ), seuil_button );
+  gtk_container_add( GTK_CONTAINER( vbox1 ), otsu_button );
   gtk_container_add( GTK_CONTAINER( vbox1 ), connexe_button );
+  gtk_container_add( GTK_CONTAINER( vbox1 ), plages_button );
+  gtk_container_add( GTK_CONTAINER( vbox1 ), huit_voisins_button );
 
   gtk_container_add( GTK_CONTAINER( vbox1 ), floue_widget );
   gtk_container_add( GTK_CONTAINER( vbox1 ), floue_button );
+  gtk_container_add( GTK_CONTAINER( vbox1 ), temps_reel_button );
+  gtk_container_add( GTK_CONTAINER( vbox1 ), progressif_button );
+  gtk_container_add( GTK_CONTAINER( vbox1 ), progression );
+  // Seulement si le programme est compilé avec l'instrumentation.
+  if ( instrumentationActive() )
+  {
+    mesures_button = gtk_button_new_with_label( "Exporter les mesures" );
+    g_signal_connect( mesures_button, "clicked",
+                      G_CALLBACK( exporterMesures ),
+                      pCtxt );
+    gtk_container_add( GTK_CONTAINER( vbox1 ), mesures_button );
+  }
 
   gtk_container_add( GTK_CONTAINER( vbox1 ), button_quit );
   // Rajoute la vbox  dans le conteneur window.
@@ -409,7 +571,8 @@ GtkWidget* creerIHM( const char* image_filename, Contexte* pCtxt )
 
 /** 
     Utile pour vérifier que le GdkPixbuf a un formal usuel: 3 canaux RGB, 24 bits par pixel,
-    et que la machine supporte l'alignement de la structure sur 3 octets.
+    ou 4 canaux RGBA, 32 bits par pixel, et que la machine supporte l'alignement de la
+    structure sur 3 octets.
 */
 void analyzePixbuf( GdkPixbuf* pixbuf )
 {
@@ -431,40 +594,23 @@ void analyzePixbuf( GdkPixbuf* pixbuf )
   printf( "sizeof(Pixel)=%ld\n", sizeof(Pixel) );
   size_t diff = ((guchar*) (pixel+1)) - (guchar*) pixel;
   printf( "(pixel+1) - pixel=%ld\n", diff );
-  assert( n_channels == 3 );
-  assert( has_alpha == FALSE );
+  assert( n_channels == ( has_alpha ? 4 : 3 ) );
   assert( bits_per_sample == 8 );
   assert( sizeof(Pixel) == 3 );
   assert( diff == 3 );
 }
 
 /**
-   Crée un image vide de taille width x height.
+   Crée un image vide de taille width x height, avec un canal alpha si
+   \a alpha (opaque: les algorithmes ne l'écrivent jamais).
 */
-GdkPixbuf* creerImage( int width, int height )
+GdkPixbuf* creerImage( int width, int height, bool alpha )
 {
-  GdkPixbuf* img = gdk_pixbuf_new(GDK_COLORSPACE_RGB, 0, 8, width, height );
+  GdkPixbuf* img = gdk_pixbuf_new(GDK_COLORSPACE_RGB, alpha, 8, width, height );
+  if ( alpha ) gdk_pixbuf_fill( img, 0x000000ff );
   return img;
 }
 
-/**
-   Retourne le niveau de gris du pixel.
-*/
-unsigned char greyLevel( Pixel* data )
-{
-  return (data->rouge+data->vert+data->bleu)/3;
-}
-
-/**
-   Met le pixel au niveau de gris \a g.
-*/
-void setGreyLevel( Pixel* data, unsigned char g )
-{
-  data->rouge = g;
-  data->vert  = g;
-  data->bleu  = g;
-}
-
 /** 
     Va au pixel de coordonnées (x,y) dans le pixbuf.
 */
@@ -472,7 +618,8 @@ Pixel* gotoPixel( GdkPixbuf* pixbuf, int x, int y )
 {
    int rowstride = gdk_pixbuf_get_rowstride( pixbuf );
    guchar* data  = gdk_pixbuf_get_pixels( pixbuf );
-   return (Pixel*)( data + y*rowstride + x*3 );
+   int n_channels = gdk_pixbuf_get_n_channels( pixbuf ); // 3, ou 4 avec l'alpha
+   return (Pixel*)( data + y*rowstride + x*n_channels );
 }
 
 /**
@@ -487,133 +634,12 @@ void disk( GdkPixbuf* pixbuf, int r )
   int y0 = height/2;
   for ( y = 0; y < height; ++y )
     {
-      Pixel* pixel = gotoPixel( pixbuf, 0, y ); // les lignes peuvent être réalignées
       for ( x = 0; x < width; ++x )
         {
+          Pixel* pixel = gotoPixel( pixbuf, x, y ); // 3 ou 4 octets par pixel
           int d2 = (x-x0)*(x-x0)+(y-y0)*(y-y0);
           if ( d2 >= r*r ) setGreyLevel( pixel, 0 );
           else setGreyLevel( pixel, 255-(int) sqrt(d2));
-          ++pixel; // sur une ligne, les pixels se suivent
         }
     }
 }
-
-/**
-   Creer un objet par pixel
- */
-Objet* creerEnsembles( GdkPixbuf* pixbuf ) 
-{
-  int rowstride = gdk_pixbuf_get_rowstride( pixbuf );
-  guchar* data  = gdk_pixbuf_get_pixels( pixbuf );
-  int width     = gdk_pixbuf_get_width( pixbuf );
-  int height    = gdk_pixbuf_get_height( pixbuf );
-
-  Objet *objects = (Objet*) malloc(width*height*sizeof(Objet));
-  int cpt_obj = 0;
-
-  for ( int y = 0; y < height; ++y )
-  {
-    Pixel* pixel = (Pixel*) data;
-    for ( int x = 0; x < width; ++x ) 
-    {
-      objects[cpt_obj].pixel = pixel;
-      objects[cpt_obj].rang = 1;
-      objects[cpt_obj].pere = &objects[cpt_obj];
-
-      pixel++;
-      cpt_obj++;
-    }
-    data += rowstride;
-  }
-
-  return objects;
-}
-
-Objet* trouverPasOpti( Objet* object )
-{
-  if(object == object->pere)
-  {
-    return object;
-  }
-  return trouverPasOpti( object->pere );
-}
-
-Objet* trouverOpti( Objet* obj )
-{
-  if (obj != obj->pere)
-    obj->pere = trouverOpti( obj->pere);
-
-  return obj->pere;
-}
-
-void unionPasOpti(Objet* obj1, Objet* obj2)
-{
-  Objet* u = trouverPasOpti( obj1 );
-  Objet* y = trouverPasOpti( obj2 );
-  u->pere = y;
-}
-
-void unionOpti( Objet* obj1, Objet* obj2 )
-{
-  Objet* u = trouverOpti(obj1);
-  Objet* v = trouverOpti(obj2);
-
-  if (u->rang > v->rang)
-    v->pere = u;
-  else 
-    u->pere = v;
-  
-  if (u->rang == v->rang)
-    v->rang = v->rang + 1;
-}
-
-TSVCouleur tsv(Pixel* pixel)
-{
-  TSVCouleur tsv;
-
-  guchar max = fmaxf(fmaxf(pixel->bleu, pixel->rouge), pixel->vert);
-  guchar min = fminf(fminf(pixel->bleu, pixel->rouge), pixel->vert);
-
-  // pour t
-  if (min == max)
-  {
-    tsv.t = 0;
-  }
-  else if (max == pixel->rouge)
-  {
-    tsv.t = ( 60 * (pixel->vert - pixel->bleu) / (max - min) + 360 ) % 360;
-  }
-  else if (max == pixel->vert)
-  {
-    tsv.t = 60 * ((pixel->bleu - pixel->rouge) / (max - min)) + 120;
-  }
-  else if (max == pixel->bleu)
-  {
-    tsv.t = 60 * ((pixel->rouge - pixel->vert) / (max - min)) + 240;
-  }
-
-  // pour s
-  if (max == 0)
-  {
-    tsv.s = 0;
-  }
-  else
-  {
-    tsv.s = 1 - (min / max);
-  }
-
-  // pour v
-  tsv.v = max;
-
-  return tsv;
-}
-
-double similitude( Pixel* p1, Pixel* p2 ) 
-{
-  TSVCouleur tsv1 = tsv( p1 );
-  TSVCouleur tsv2 = tsv( p2 );
-  int diff = tsv1.t - tsv2.t;
-  while ( diff >= 180 ) diff -= 360;
-  while ( diff <= -180 ) diff += 360;
-  return abs( (double) diff ) + 5.0 * abs( tsv1.s - tsv2.s ) + 10.0 * abs( tsv1.v - tsv2.v );
-}
\ No newline at end of file